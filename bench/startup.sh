@@ -0,0 +1,115 @@
+#!/bin/sh
+#
+# *****************************************************************************
+#
+# Project:   smallsh
+# Filename:  bench/startup.sh
+#
+#
+# Overview:
+#    Times smallsh's startup, and what searching PATH adds to starting a
+#    program. The second part is why programs are found by execvpe() and
+#    not through an index of the PATH directories, which smallsh briefly
+#    kept: the search it would save is too small to pay for keeping an
+#    index up to date.
+#
+#    Usage: bench/startup.sh [smallsh binary] [external shell] [runs]
+#
+#    Each case is run 'runs' times (default 20); the median and fastest
+#    times are printed, in milliseconds:
+#
+#       first prompt   -T stamp for the first prompt (no script)
+#       first exec     -T stamp for the first program of a one-line script
+#       run            wall-clock time of 'smallsh script', where the
+#                      script runs 'uname' once, found through a PATH of
+#                      5 directories, or 61 with 59 empty ones in front
+#       sh run         the same script run by the external shell
+#
+#    On a 2026 Linux VM with dash as sh, 200 runs (ms):
+#
+#       case                 median      min
+#       first prompt          0.047    0.029
+#       first exec            0.121    0.106
+#       run, PATH 5           1.566    1.415
+#       run, PATH 61          1.614    1.479
+#       sh run, PATH 5        1.475    1.291
+#       sh run, PATH 61       1.628    1.377
+#
+#    59 more directories to search add about 0.05 ms to a program start of
+#    about 1.5 ms, less than they add for the external shell.
+#
+# *****************************************************************************
+#
+
+SMALLSH=${1:-./smallsh}
+EXTSH=${2:-/bin/sh}
+RUNS=${3:-20}
+
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+echo uname > "$DIR/one.sh"
+
+# PATH with 59 empty directories ahead of a normal one.
+#
+LONGPATH=/usr/bin:/bin
+i=1
+while [ $i -le 59 ]; do
+    mkdir "$DIR/p$i"
+    LONGPATH=$DIR/p$i:$LONGPATH
+    i=$((i + 1))
+done
+SHORTPATH=/usr/local/bin:/usr/bin:/bin:/usr/local/sbin:/usr/sbin
+
+# Reads one number per line and prints the median and the smallest.
+#
+stats()
+{
+    sort -n | awk '{ v[NR] = $1 }
+                   END { printf "%8.3f %8.3f\n", v[int((NR + 1) / 2)], v[1] }'
+}
+
+# Prints the -T stamp of step $1 for $RUNS runs of smallsh with the rest of
+# the arguments.
+#
+stamp()
+{
+    step=$1
+    shift
+    n=0
+    while [ $n -lt "$RUNS" ]; do
+        "$SMALLSH" -T "$@" > /dev/null 2>> "$DIR/trace" < /dev/null
+        n=$((n + 1))
+    done
+    sed -n "s/^smallsh: startup *\([0-9.]*\) ms: $step\$/\1/p" "$DIR/trace"
+    rm -f "$DIR/trace"
+}
+
+# Prints the wall-clock time of $RUNS runs of the arguments, run with PATH
+# set to $1, in milliseconds.
+#
+wall()
+{
+    path=$1
+    shift
+    n=0
+    while [ $n -lt "$RUNS" ]; do
+        t0=$(date +%s%N)
+        PATH=$path "$@" > /dev/null 2>&1 < /dev/null
+        t1=$(date +%s%N)
+        echo "$(( (t1 - t0) / 1000 ))" | awk '{ print $1 / 1000 }'
+        n=$((n + 1))
+    done
+}
+
+printf '%-18s %8s %8s\n' case median min
+printf '%-18s %s\n' "first prompt" "$(stamp "first prompt" | stats)"
+printf '%-18s %s\n' "first exec" "$(stamp "first exec" "$DIR/one.sh" | stats)"
+printf '%-18s %s\n' "run, PATH 5" \
+    "$(wall "$SHORTPATH" "$SMALLSH" "$DIR/one.sh" | stats)"
+printf '%-18s %s\n' "run, PATH 61" \
+    "$(wall "$LONGPATH" "$SMALLSH" "$DIR/one.sh" | stats)"
+printf '%-18s %s\n' "sh run, PATH 5" \
+    "$(wall "$SHORTPATH" "$EXTSH" "$DIR/one.sh" | stats)"
+printf '%-18s %s\n' "sh run, PATH 61" \
+    "$(wall "$LONGPATH" "$EXTSH" "$DIR/one.sh" | stats)"
@@ -9,7 +9,8 @@
 //
 //
 // Overview:
-//    Basic shell with three built-in commands and basic signal handling.
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language (if/while/for, && and ||, functions).
 //
 //    This file contains variable definitions and function prototypes.
 //
@@ -22,36 +23,104 @@
 
 
 #include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+#include "smallsh_ring.h"
 
 
 #define PROMPT    ": "          // Basic command prompt string
+#define CONT_PROMPT "> "        // Prompt for continuation lines
 #define MAX_USER_INPUT 2048     // Maximum length of user input
+#define MAX_STATEMENT 262144    // Maximum length of a multi-line statement
 #define MAX_ARGS  512           // Maximum number of arguments from the user
+#define MAX_NEST  64            // Maximum nesting of compound commands
+#define MAX_FUNC_DEPTH 256      // Maximum depth of nested function calls
+#define ARENA_BLOCK_SIZE 8192   // Default size of an arena block
+#define JOB_ARGV_MAX 256        // Bytes of arguments kept per background job
+#define JOB_RING_SIZE 64        // Finished background jobs remembered
+#define STATS_MAX_CLIENTS 16    // Stats socket clients served at once
+#define STATS_TIMEOUT_MS 1000   // Time a stats client gets to query, and to read
 
 
-int pstatus; // holds whatever status happens to be the latest
+extern int pstatus; // holds whatever status happens to be the latest
 
 
 // struct Node: Holds PID information for a background process
 //
-// pid  -> PID of the process, returned by fork()
+// pid   -> PID of the process, returned by fork()
 //
-// next -> The next node in the list
+// start -> When the process was started (wall clock)
+//
+// argc, argv -> The process's arguments, packed one after another with
+//          NUL separators (truncated to JOB_ARGV_MAX bytes)
+//
+// progress, result -> Latest progress and result messages the process
+//          posted to the status ring (empty if none)
+//
+// next  -> The next node in the list
 //
 struct Node {
     pid_t pid;
+    struct timespec start;
+    int argc;
+    char argv[JOB_ARGV_MAX];
+    char progress[STATUS_MSG_MAX];
+    char result[STATUS_MSG_MAX];
     struct Node *next;
 };
 
 
+// struct JobRecord: A background process that has finished
+//
+// pid, start, argc, argv, progress, result -> Copied from the process's
+//          struct Node (result may still arrive after the process is reaped)
+//
+// end      -> When the process was reaped
+//
+// status   -> Exit status data from waitpid()
+//
+// notified -> The "background pid N is done" message has been printed
+//
+struct JobRecord {
+    pid_t pid;
+    struct timespec start;
+    struct timespec end;
+    int status;
+    char notified;
+    int argc;
+    char argv[JOB_ARGV_MAX];
+    char progress[STATUS_MSG_MAX];
+    char result[STATUS_MSG_MAX];
+};
+
+
+// struct JobRing: The most recently finished background processes. Once
+// the ring is full, each new record replaces the oldest one.
+//
+// count -> Number of records ever added; the newest is at
+//          rec[(count - 1) % JOB_RING_SIZE]
+//
+struct JobRing {
+    struct JobRecord rec[JOB_RING_SIZE];
+    unsigned int count;
+};
+
+
+struct Shell;
+
+
 // *****************************************************************************
 // 
-// struct Node *addNode(int newPid, struct Node *head)
+// struct Node *addNode(int newPid, char *userArgs[], struct Node *head)
 //
 //    Entry:   int newPid
 //                PID to add to the background process PID list
+//             char *userArgs[]
+//                NULL-terminated argument list the process was started with
 //             struct Node *head
-//                Pointer to the head node of the list
+//                Pointer to the head node of the list (NULL if it is empty)
 //
 //    Exit:    Returns a pointer to the new head node.
 //
@@ -59,44 +128,45 @@ struct Node {
 //
 // *****************************************************************************
 //
-struct Node *addNode(int newPid, struct Node *head);
+struct Node *addNode(int newPid, char *userArgs[], struct Node *head);
 
 
 // *****************************************************************************
 // 
-// struct Node *clearChildren(struct Node *head, int *numNodes)
+// void clearChildren(struct Shell *sh)
 //
-//    Entry:   struct Node *head
-//                Pointer to the head node of the list
-//             int *numNodes
-//                Pointer to integer containing the number of nodes in the list.
+//    Entry:   struct Shell *sh
+//                Shell whose background process list is checked.
 //
-//    Exit:    Returns the pointer to head, in case it is needed.
+//    Exit:    None.
 //
-//    Purpose: Walk through a list of background PIDs and reap zombies.
+//    Purpose: Reap zombies from the background process list and report
+//             every background process that has finished.
 //
 // *****************************************************************************
 //
-struct Node *clearChildren(struct Node *head, int *numNodes);
+void clearChildren(struct Shell *sh);
 
 
 // *****************************************************************************
 // 
-// void myCd(char *userArgs[], int numArgs)
+// int myCd(struct Shell *sh, char *userArgs[], int numArgs)
 //
-//    Entry:   char *userArgs[]
+//    Entry:   struct Shell *sh
+//                Shell whose HOME variable 'cd' with no argument goes to.
+//             char *userArgs[]
 //                Pointer array containing a NULL-terminated list of arguments.
 //             int numArgs
 //                Integer containing the number of command line arguments + NULL.
 //
-//    Exit:    None.
+//    Exit:    Returns 0 if the directory was changed, 1 otherwise.
 //
 //    Purpose: Change to a directory specified by the user (or home directory
 //             if no directory was specified).
 //
 // *****************************************************************************
 //
-void myCd(char *userArgs[], int numArgs);
+int myCd(struct Shell *sh, char *userArgs[], int numArgs);
 
 
 // *****************************************************************************
@@ -116,6 +186,75 @@ void myCd(char *userArgs[], int numArgs);
 void myStatus(int pstatus);
 
 
+
+// *****************************************************************************
+// 
+// int exitCode(int status)
+//
+//    Entry:   int status
+//                Status returned by waitpid().
+//
+//    Exit:    Returns the process's exit value, or 128 + signal number if it
+//             was killed by a signal.
+//
+//    Purpose: Turn a waitpid() status into a shell exit code.
+//
+// *****************************************************************************
+//
+int exitCode(int status);
+
+
+// *****************************************************************************
+// 
+// void traceStart(const struct timespec *start)
+//
+//    Entry:   const struct timespec *start
+//                CLOCK_MONOTONIC time taken on entry to main().
+//
+//    Exit:    None.
+//
+//    Purpose: Turn on startup tracing (-T). Times reported by tracePoint()
+//             and traceEnd() are measured from start.
+//
+// *****************************************************************************
+//
+void traceStart(const struct timespec *start);
+
+
+// *****************************************************************************
+// 
+// void tracePoint(const char *fmt, ...)
+//
+//    Entry:   const char *fmt, ...
+//                printf()-style description of the step just finished.
+//
+//    Exit:    None.
+//
+//    Purpose: If startup is being traced, print the time since main() was
+//             entered and the step to stderr.
+//
+// *****************************************************************************
+//
+void tracePoint(const char *fmt, ...);
+
+
+// *****************************************************************************
+// 
+// void traceEnd(const char *what)
+//
+//    Entry:   const char *what
+//                Step that ends startup ("first prompt", "exec ls", ...), or
+//                NULL to stop tracing without printing anything.
+//
+//    Exit:    None.
+//
+//    Purpose: Report the end of startup and turn tracing off.
+//
+// *****************************************************************************
+//
+void traceEnd(const char *what);
+
+
 // Set up a generic function pointer type so we can collect functions with
 // disparate argument lists in one function pointer array. The functions
 // will need to be cast to one of the other two types (listed below this
@@ -128,7 +267,7 @@ typedef void (*generic_fp)();
 // its arguments. This is used for commands that take command line parameters, 
 // like 'cd'.
 //
-typedef void (*builtin_arg)(char *userArgs[], int numArgs);
+typedef int (*builtin_arg)(char *userArgs[], int numArgs);
 
 
 // A function pointer type that accepts process status arguments. This 
@@ -137,4 +276,589 @@ typedef void (*builtin_arg)(char *userArgs[], int numArgs);
 typedef void (*builtin_arg_proc)(int pstatus);
 
 
+// A function pointer type that accepts the shell state along with the
+// command line. This is used for commands that report on the shell itself,
+// like 'jobs'.
+//
+typedef int (*builtin_arg_shell)(struct Shell *sh, char *userArgs[], int numArgs);
+
+
+// *****************************************************************************
+//
+// Arena allocator
+//
+//    Syntax trees are bump-allocated out of an arena. The arena that holds a
+//    top-level statement is reset once the statement has run, so neither the
+//    parser nor the evaluator frees individual nodes.
+//
+// *****************************************************************************
+//
+
+// struct ArenaBlock: One chunk of arena memory
+//
+// prev -> The block that was filled before this one (NULL for the first)
+//
+// size -> Usable bytes in data[]
+//
+// used -> Bytes handed out so far
+//
+struct ArenaBlock {
+    struct ArenaBlock *prev;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+// struct Arena: A chain of blocks, newest first
+//
+struct Arena {
+    struct ArenaBlock *curr;
+};
+
+// struct ArenaMark: A saved arena position (see arenaMark()/arenaRelease())
+//
+struct ArenaMark {
+    struct ArenaBlock *block;
+    size_t used;
+};
+
+
+// *****************************************************************************
+//
+// void arenaInit(struct Arena *arena)
+//
+//    Entry:   struct Arena *arena
+//                Arena to initialize. No memory is allocated until first use.
+//
+//    Exit:    None.
+//
+//    Purpose: Prepare an empty arena.
+//
+// *****************************************************************************
+//
+void arenaInit(struct Arena *arena);
+
+
+// *****************************************************************************
+//
+// void *arenaAlloc(struct Arena *arena, size_t size)
+//
+//    Entry:   struct Arena *arena
+//                Arena to allocate from.
+//             size_t size
+//                Number of bytes needed.
+//
+//    Exit:    Returns a pointer to zeroed, suitably aligned memory. Exits the
+//             shell if memory cannot be allocated.
+//
+//    Purpose: Bump-allocate memory that lives until the arena is released.
+//
+// *****************************************************************************
+//
+void *arenaAlloc(struct Arena *arena, size_t size);
+
+
+// *****************************************************************************
+//
+// char *arenaStrndup(struct Arena *arena, const char *str, size_t len)
+//
+//    Entry:   struct Arena *arena
+//                Arena to allocate from.
+//             const char *str
+//                Characters to copy.
+//             size_t len
+//                Number of characters to copy.
+//
+//    Exit:    Returns a NUL-terminated copy of the characters.
+//
+//    Purpose: Copy part of a string into the arena.
+//
+// *****************************************************************************
+//
+char *arenaStrndup(struct Arena *arena, const char *str, size_t len);
+
+
+// *****************************************************************************
+//
+// struct ArenaMark arenaMark(struct Arena *arena)
+// void arenaRelease(struct Arena *arena, struct ArenaMark mark)
+//
+//    Purpose: Save the current arena position, and later give back every
+//             allocation made since that position was saved. Used for
+//             scratch memory (expanded words, argv arrays) while running
+//             a command.
+//
+// *****************************************************************************
+//
+struct ArenaMark arenaMark(struct Arena *arena);
+void arenaRelease(struct Arena *arena, struct ArenaMark mark);
+
+
+// *****************************************************************************
+//
+// void arenaReset(struct Arena *arena)
+// void arenaFree(struct Arena *arena)
+//
+//    Purpose: arenaReset() releases everything but keeps the first block for
+//             reuse; arenaFree() gives all memory back to the system.
+//
+// *****************************************************************************
+//
+void arenaReset(struct Arena *arena);
+void arenaFree(struct Arena *arena);
+
+
+// *****************************************************************************
+//
+// Syntax tree
+//
+// *****************************************************************************
+//
+
+// Node types
+//
+enum NodeType {
+    N_CMD,          // simple command: words, redirections, background flag
+    N_AND,          // left && right
+    N_OR,           // left || right
+    N_IF,           // if cond; then body; [elif ...|else elseBody;] fi
+    N_WHILE,        // while cond; do body; done
+    N_UNTIL,        // until cond; do body; done
+    N_FOR,          // for name [in words]; do body; done
+    N_GROUP,        // { body; }
+    N_FUNCDEF       // name() compound-command
+};
+
+// struct AstNode: One node of the syntax tree. Which fields are used depends
+// on the node type (see enum NodeType).
+//
+// next     -> Next command in a list (separated by ';', '&' or newline)
+//
+// left, right -> Operands of && and ||
+//
+// cond, body, elseBody -> Parts of compound commands. An elif is stored as
+//             an N_IF node in elseBody.
+//
+// words    -> NULL-terminated word list (command arguments or for-loop items)
+//
+// redirIn, redirOut -> Redirection file names, or NULL
+//
+// name     -> Loop variable (N_FOR) or function name (N_FUNCDEF)
+//
+// src, srcLen -> Source text of a function body (N_FUNCDEF)
+//
+// bg       -> Simple command was followed by '&'
+//
+// hasIn    -> For loop had an "in" word list
+//
+struct AstNode {
+    int type;
+    struct AstNode *next;
+    struct AstNode *left;
+    struct AstNode *right;
+    struct AstNode *cond;
+    struct AstNode *body;
+    struct AstNode *elseBody;
+    char **words;
+    int numWords;
+    char *redirIn;
+    char *redirOut;
+    char *name;
+    const char *src;
+    size_t srcLen;
+    char bg;
+    char hasIn;
+};
+
+// Parser results
+//
+#define PARSE_OK         0      // a complete statement was parsed
+#define PARSE_ERROR      1      // syntax error, message in errMsg
+#define PARSE_INCOMPLETE 2      // input ended inside a statement
+
+
+// *****************************************************************************
+//
+// int parseScript(const char *src, size_t len, struct Arena *arena,
+//                 struct AstNode **tree, char *errMsg, size_t errLen)
+//
+//    Entry:   const char *src, size_t len
+//                Script text to parse. Need not be NUL-terminated.
+//             struct Arena *arena
+//                Arena the syntax tree is allocated from.
+//             struct AstNode **tree
+//                Receives the parsed command list (NULL for an empty script).
+//             char *errMsg, size_t errLen
+//                Buffer for a syntax error message.
+//
+//    Exit:    Returns PARSE_OK, PARSE_ERROR or PARSE_INCOMPLETE.
+//
+//    Purpose: Build a syntax tree from script text. Has no side effects other
+//             than allocating from the arena.
+//
+// *****************************************************************************
+//
+int parseScript(const char *src, size_t len, struct Arena *arena,
+                struct AstNode **tree, char *errMsg, size_t errLen);
+
+
+// *****************************************************************************
+//
+// Shell variables
+//
+//    Variables live in a hash table owned by the shell rather than in the
+//    process environment: setenv() never frees a value it replaces, so a
+//    loop assigning a variable would grow the shell for as long as it runs.
+//    Every variable is exported; the environment handed to a program is
+//    built from the table when it is started.
+//
+// *****************************************************************************
+//
+
+// struct Var: One variable
+//
+// str     -> "NAME=value", ready to be used as an environment entry
+//
+// nameLen -> Length of NAME
+//
+// cap     -> Allocated size of str, so a new value that fits is copied in
+//            place
+//
+struct Var {
+    char *str;
+    size_t nameLen;
+    size_t cap;
+};
+
+// struct VarTable: Open-addressed table of variables
+//
+// slot    -> size slots, NULL until the process environment is first
+//            copied in
+//
+// env     -> NULL-terminated environment built from the table, or NULL if
+//            it has to be rebuilt
+//
+struct VarTable {
+    struct Var *slot;
+    size_t size;
+    size_t count;
+    char **env;
+};
+
+
+// *****************************************************************************
+//
+// const char *getVar(struct Shell *sh, const char *name, size_t nameLen)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose variables are searched.
+//             const char *name, size_t nameLen
+//                Variable name. Need not be NUL-terminated.
+//
+//    Exit:    Returns the variable's value, or NULL if it is not set. The
+//             value is valid until the variable is next set.
+//
+//    Purpose: Look up a shell (or inherited environment) variable.
+//
+// *****************************************************************************
+//
+const char *getVar(struct Shell *sh, const char *name, size_t nameLen);
+
+
+// *****************************************************************************
+//
+// void setVar(struct Shell *sh, const char *name, size_t nameLen,
+//             const char *value)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose variable is set.
+//             const char *name, size_t nameLen
+//                Variable name. Need not be NUL-terminated.
+//             const char *value
+//                New value.
+//
+//    Exit:    None. Exits the shell if memory cannot be allocated.
+//
+//    Purpose: Set (and export) a variable. The old value's memory is reused
+//             or freed.
+//
+// *****************************************************************************
+//
+void setVar(struct Shell *sh, const char *name, size_t nameLen,
+            const char *value);
+
+
+// *****************************************************************************
+//
+// char **varEnviron(struct Shell *sh)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose variables are exported.
+//
+//    Exit:    Returns a NULL-terminated "NAME=value" array, valid until the
+//             next setVar().
+//
+//    Purpose: Give a program about to be exec'd its environment. The array
+//             is only rebuilt after a variable has been set.
+//
+// *****************************************************************************
+//
+char **varEnviron(struct Shell *sh);
+
+
+// *****************************************************************************
+//
+// void freeVars(struct Shell *sh)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose variables are released.
+//
+//    Exit:    None.
+//
+//    Purpose: Free the variable table and the environment built from it.
+//
+// *****************************************************************************
+//
+void freeVars(struct Shell *sh);
+
+
+// *****************************************************************************
+//
+// Evaluation
+//
+// *****************************************************************************
+//
+
+// Pending control flow (struct Shell ctl field)
+//
+#define CTL_NONE     0
+#define CTL_BREAK    1          // "break" ran inside a loop
+#define CTL_CONTINUE 2          // "continue" ran inside a loop
+#define CTL_RETURN   3          // "return" ran inside a function
+#define CTL_ABORT    4          // foreground job was interrupted by SIGINT
+
+// struct Func: A shell function
+//
+// name  -> Function name
+//
+// src   -> Copy of the function body text
+//
+// arena -> Arena holding the parsed body; lives as long as the function
+//
+// body  -> Parsed body
+//
+// busy  -> Number of active calls (a running function cannot be redefined)
+//
+// next  -> The next function in the list
+//
+struct Func {
+    char *name;
+    char *src;
+    struct Arena arena;
+    struct AstNode *body;
+    int busy;
+    struct Func *next;
+};
+
+// struct Shell: State shared by the main loop and the evaluator
+//
+struct Shell {
+    struct Node *head;          // Front node in background proc list
+    int numNodes;               // Number of background proc in list
+    struct JobRing done;        // Recently finished background procs
+    char cont;                  // 'y' to keep going, 'n' once "exit" ran
+    int exitStatus;             // Status to exit the shell with
+    int lastStatus;             // Exit code of the last command ($?)
+    int ctl;                    // Pending break/continue/return (CTL_*)
+    int loopDepth;              // Loops enclosing the running command
+    int funcDepth;              // Active function calls
+    char **posArgs;             // Positional parameters ($0, $1, ...)
+    int numPosArgs;             // Number of positional parameters incl. $0
+    struct Func *funcs;         // Defined functions
+    struct Arena *arena;        // Arena of the running top-level statement
+    struct VarTable vars;       // Shell variables
+};
+
+
+// *****************************************************************************
+//
+// int evalTree(struct Shell *sh, struct AstNode *tree)
+//
+//    Entry:   struct Shell *sh
+//                Shell state. sh->arena must be the arena holding the tree.
+//             struct AstNode *tree
+//                Command list returned by parseScript().
+//
+//    Exit:    Returns the exit code of the last command that ran.
+//
+//    Purpose: Run a parsed statement. Builtins, functions and fork/exec'd
+//             programs are the leaf operations.
+//
+// *****************************************************************************
+//
+int evalTree(struct Shell *sh, struct AstNode *tree);
+
+
+// *****************************************************************************
+//
+// Job registry
+//
+//    The background process list and the ring of finished processes can be
+//    read by the stats socket thread, so both are only touched while
+//    holding the job lock.
+//
+// *****************************************************************************
+//
+
+
+// *****************************************************************************
+//
+// void lockJobs(void)
+// void unlockJobs(void)
+//
+//    Purpose: Take and release the lock that guards sh->head, sh->numNodes
+//             and sh->done.
+//
+// *****************************************************************************
+//
+void lockJobs(void);
+void unlockJobs(void);
+
+
+// *****************************************************************************
+//
+// void reapJobs(struct Shell *sh)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose background process list is checked. The job
+//                lock must be held.
+//
+//    Exit:    None.
+//
+//    Purpose: Reap any finished background processes without waiting and
+//             move them from the process list to the finished ring. Nothing
+//             is printed; clearChildren() reports them later.
+//
+// *****************************************************************************
+//
+void reapJobs(struct Shell *sh);
+
+
+// *****************************************************************************
+//
+// int createStatusRing(struct Shell *sh)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose variables get SMALLSH_STATUS_FD.
+//
+//    Exit:    Returns 0 on success, -1 (with a message printed) on failure.
+//
+//    Purpose: Create the shared-memory status ring (see smallsh_ring.h) in a
+//             memfd that children inherit, and advertise its descriptor in
+//             SMALLSH_STATUS_FD. Only the first call does anything, so it is
+//             called just before each program is started: a shell that
+//             never starts one never pays for the ring.
+//
+// *****************************************************************************
+//
+int createStatusRing(struct Shell *sh);
+
+
+// *****************************************************************************
+//
+// void drainStatus(struct Shell *sh)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose jobs are updated. The job lock must be held.
+//
+//    Exit:    None.
+//
+//    Purpose: Read every record posted to the status ring and store the
+//             message with the job (running or finished) it is about.
+//             Records for PIDs that are not background jobs are dropped.
+//
+// *****************************************************************************
+//
+void drainStatus(struct Shell *sh);
+
+
+// *****************************************************************************
+//
+// void writeJobsJson(struct Shell *sh, FILE *out)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose jobs are listed. The job lock must be held.
+//             FILE *out
+//                Stream the JSON document is written to.
+//
+//    Exit:    None.
+//
+//    Purpose: Describe running and recently finished background processes
+//             as a single-line JSON object.
+//
+// *****************************************************************************
+//
+void writeJobsJson(struct Shell *sh, FILE *out);
+
+
+// *****************************************************************************
+//
+// int myJobs(struct Shell *sh, char *userArgs[], int numArgs)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose jobs are listed.
+//             char *userArgs[], int numArgs
+//                Command line ("jobs" or "jobs --json").
+//
+//    Exit:    Returns 0 on success, 1 on a usage error.
+//
+//    Purpose: Built-in jobs command. Lists running and recently finished
+//             background processes, as text or as JSON.
+//
+// *****************************************************************************
+//
+int myJobs(struct Shell *sh, char *userArgs[], int numArgs);
+
+
+// *****************************************************************************
+//
+// int startStatsServer(struct Shell *sh, const char *path)
+//
+//    Entry:   struct Shell *sh
+//                Shell whose jobs are reported.
+//             const char *path
+//                File system path of the Unix-domain socket to listen on.
+//
+//    Exit:    Returns 0 on success, -1 (with a message printed) on failure.
+//
+//    Purpose: Answer job queries on a Unix-domain socket from a separate
+//             thread, so queries are served even while the shell waits at
+//             the prompt or for a foreground process. A client connects,
+//             optionally sends a query line ("jobs", the default), and reads
+//             one JSON line back.
+//
+// *****************************************************************************
+//
+int startStatsServer(struct Shell *sh, const char *path);
+
+
+// *****************************************************************************
+//
+// int runServer(const char *path)
+//
+//    Entry:   const char *path
+//                File system path of the Unix-domain socket to listen on.
+//
+//    Exit:    Returns 0 after SIGINT or SIGTERM, 1 if the server could not be
+//             started.
+//
+//    Purpose: Run the shell in server mode: accept framed command requests
+//             (see smallsh_proto.h) from any number of clients, run them
+//             concurrently, and stream their output and exit codes back.
+//
+// *****************************************************************************
+//
+int runServer(const char *path);
+
+
 #endif
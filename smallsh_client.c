@@ -0,0 +1,254 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_client.c
+//
+//
+// Overview:
+//    smallsh-client: runs one command through a shell in server mode
+//    ('smallsh -l socket') and passes its output and exit code through, as
+//    if the command had been run directly.
+//
+// Input:
+//    smallsh-client [-C dir] [-e NAME=value]... [-i] socket command [args...]
+//
+//    -C dir         Run the command in dir
+//    -e NAME=value  Set an environment variable for the command
+//    -i             Send this program's stdin to the command (otherwise the
+//                   command's stdin is /dev/null)
+//
+// Output:
+//    The command's stdout and stderr. Exits with the command's exit code,
+//    or 127 if the server rejected the request.
+//
+// *****************************************************************************
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "smallsh_proto.h"
+
+
+#define REQUEST_ID 1            // Only one request per connection here
+
+
+// *****************************************************************************
+//
+// static void writeAll(int fd, const void *data, size_t len)
+//
+// Purpose: Writes all of data to fd, exiting if that fails.
+//
+// *****************************************************************************
+//
+static void writeAll(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *) data;
+    ssize_t n;
+
+    while(len > 0)
+    {
+        n = write(fd, p, len);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0)
+        {
+            perror("smallsh-client: write");
+            exit(1);
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+
+// *****************************************************************************
+//
+// static int readAll(int fd, void *data, size_t len)
+//
+// Purpose: Reads exactly len bytes from fd. Returns 0, or -1 at end of file.
+//
+// *****************************************************************************
+//
+static int readAll(int fd, void *data, size_t len)
+{
+    char *p = (char *) data;
+    ssize_t n;
+
+    while(len > 0)
+    {
+        n = read(fd, p, len);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n <= 0)
+        {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static void sendFrame(int fd, uint32_t type, const void *data, size_t len)
+//
+// Purpose: Sends one frame of the request.
+//
+// *****************************************************************************
+//
+static void sendFrame(int fd, uint32_t type, const void *data, size_t len)
+{
+    struct FrameHeader hdr;
+
+    hdr.type = type;
+    hdr.id = REQUEST_ID;
+    hdr.len = (uint32_t)len;
+    writeAll(fd, &hdr, sizeof(hdr));
+    writeAll(fd, data, len);
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_un addr;             // Server socket address
+    struct FrameHeader hdr;              // Header of a frame from the server
+    static char buf[FRAME_MAX_PAYLOAD];  // Payload buffer
+    char *cwd = NULL;                    // Directory to run in (-C)
+    int sendStdin = 0;                   // Forward stdin (-i)
+    int32_t code;                        // Command's exit code
+    ssize_t n;
+    int opt;                             // Command line option letter
+    int fd;                              // Connection to the server
+    int i;
+
+    // Environment settings are sent once the connection is up, so remember
+    // them until then. There cannot be more of them than arguments; the
+    // shell rejects the request if there are more than it takes.
+    //
+    char **env;
+    int numEnv = 0;
+
+    env = (char **) calloc(argc, sizeof(char *));
+    if(env == NULL)
+    {
+        perror(argv[0]);
+        exit(1);
+    }
+
+    while((opt = getopt(argc, argv, "+C:e:i")) != -1)
+    {
+        switch(opt)
+        {
+            case 'C':
+                cwd = optarg;
+                break;
+            case 'e':
+                env[numEnv++] = optarg;
+                break;
+            case 'i':
+                sendStdin = 1;
+                break;
+            default:
+                optind = argc;
+        }
+    }
+
+    if(argc - optind < 2)
+    {
+        fprintf(stderr, "usage: %s [-C dir] [-e NAME=value]... [-i] socket command [args...]\n",
+                argv[0]);
+        exit(2);
+    }
+
+    if(strlen(argv[optind]) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "%s: %s: socket path too long\n", argv[0], argv[optind]);
+        exit(1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, argv[optind]);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+        perror(argv[optind]);
+        exit(1);
+    }
+
+    // Build the request.
+    //
+    for(i = optind + 1; i < argc; i++)
+    {
+        sendFrame(fd, FRAME_ARG, argv[i], strlen(argv[i]));
+    }
+    for(i = 0; i < numEnv; i++)
+    {
+        sendFrame(fd, FRAME_ENV, env[i], strlen(env[i]));
+    }
+    if(cwd != NULL)
+    {
+        sendFrame(fd, FRAME_CWD, cwd, strlen(cwd));
+    }
+    if(sendStdin)
+    {
+        while((n = read(STDIN_FILENO, buf, sizeof(buf))) != 0)
+        {
+            if(n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(n < 0)
+            {
+                perror("smallsh-client: stdin");
+                exit(1);
+            }
+            sendFrame(fd, FRAME_STDIN, buf, n);
+        }
+    }
+    sendFrame(fd, FRAME_RUN, "", 0);
+
+    // Pass the output through until the final frame.
+    //
+    for(;;)
+    {
+        if(readAll(fd, &hdr, sizeof(hdr)) == -1 || hdr.len > sizeof(buf) ||
+           readAll(fd, buf, hdr.len) == -1)
+        {
+            fprintf(stderr, "%s: lost connection to the shell\n", argv[0]);
+            exit(1);
+        }
+
+        switch(hdr.type)
+        {
+            case FRAME_STDOUT:
+                writeAll(STDOUT_FILENO, buf, hdr.len);
+                break;
+            case FRAME_STDERR:
+                writeAll(STDERR_FILENO, buf, hdr.len);
+                break;
+            case FRAME_EXIT:
+                memcpy(&code, buf, sizeof(code));
+                exit(code);
+            case FRAME_ERROR:
+                fprintf(stderr, "%s: %.*s\n", argv[0], (int)hdr.len, buf);
+                exit(127);
+        }
+    }
+}
@@ -0,0 +1,999 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_eval.c
+// Based on:  main.c by Erik Ratcliffe (CS 344, Spring 2015); the fork/exec
+//            path in runExternal() is his, moved here from main().
+//
+//
+// Overview:
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language.
+//
+//    This file contains the evaluator that walks a syntax tree built by
+//    parseScript(). Simple commands are the leaves: built-ins, shell
+//    functions, or programs that are fork()'d and exec()'d.
+//
+//    The evaluator does not allocate tree nodes. Expanded words and argv
+//    arrays come out of the statement's arena and are released as soon as
+//    the command that needed them has finished, so a loop body can run any
+//    number of times without the arena growing.
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // execvpe()
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "smallsh.h"
+
+
+static int evalList(struct Shell *sh, struct AstNode *list);
+
+
+// *****************************************************************************
+//
+// static int stopping(struct Shell *sh)
+//
+// Purpose: Tells whether the rest of a command list should be skipped
+//          because of exit, break, continue, return, or an interrupt.
+//
+// *****************************************************************************
+//
+static int stopping(struct Shell *sh)
+{
+    return sh->cont != 'y' || sh->ctl != CTL_NONE;
+}
+
+
+// *****************************************************************************
+//
+// static size_t expandWord(struct Shell *sh, const char *word, char *out)
+//
+// Purpose: Expands $?, $$, $#, $0-$9, $NAME and ${NAME} in a word. If out is
+//          NULL nothing is written and only the expanded length is counted,
+//          so callers can size the buffer first.
+//
+// *****************************************************************************
+//
+static size_t expandWord(struct Shell *sh, const char *word, char *out)
+{
+    char num[24];           // Formatted numeric values
+    const char *value;      // Value to substitute
+    const char *p = word;   // Current position in the word
+    size_t len = 0;         // Length of the expansion so far
+    size_t n;               // Length of a name or value
+
+    while(*p != '\0')
+    {
+        if(*p != '$')
+        {
+            if(out != NULL)
+            {
+                out[len] = *p;
+            }
+            len++;
+            p++;
+            continue;
+        }
+
+        p++;
+        value = NULL;
+        if(*p == '?')
+        {
+            snprintf(num, sizeof(num), "%d", sh->lastStatus);
+            value = num;
+            p++;
+        }
+        else if(*p == '$')
+        {
+            snprintf(num, sizeof(num), "%d", (int)getpid());
+            value = num;
+            p++;
+        }
+        else if(*p == '#')
+        {
+            snprintf(num, sizeof(num), "%d", sh->numPosArgs > 0 ? sh->numPosArgs - 1 : 0);
+            value = num;
+            p++;
+        }
+        else if(*p >= '0' && *p <= '9')
+        {
+            value = (*p - '0') < sh->numPosArgs ? sh->posArgs[*p - '0'] : "";
+            p++;
+        }
+        else if(*p == '{' || *p == '_' || (*p >= 'a' && *p <= 'z') ||
+                (*p >= 'A' && *p <= 'Z'))
+        {
+            // Collect the variable name, with or without braces.
+            //
+            const char *start = (*p == '{') ? p + 1 : p;
+            const char *end = start;
+
+            while(*end == '_' || (*end >= 'a' && *end <= 'z') ||
+                  (*end >= 'A' && *end <= 'Z') || (*end >= '0' && *end <= '9'))
+            {
+                end++;
+            }
+            if(*p == '{' && *end != '}')
+            {
+                // Not a well-formed ${NAME}; keep the $ as is.
+                //
+                value = "$";
+            }
+            else
+            {
+                value = getVar(sh, start, (size_t)(end - start));
+                if(value == NULL)
+                {
+                    value = "";
+                }
+                p = (*p == '{') ? end + 1 : end;
+            }
+        }
+        else
+        {
+            // A lone $ stands for itself.
+            //
+            value = "$";
+        }
+
+        n = strlen(value);
+        if(out != NULL)
+        {
+            memcpy(out + len, value, n);
+        }
+        len += n;
+    }
+
+    if(out != NULL)
+    {
+        out[len] = '\0';
+    }
+
+    return len;
+}
+
+
+// *****************************************************************************
+//
+// static char *expand(struct Shell *sh, char *word)
+//
+// Purpose: Returns the expansion of a word. Words without a $ are returned
+//          as they are; others are expanded into the statement arena.
+//
+// *****************************************************************************
+//
+static char *expand(struct Shell *sh, char *word)
+{
+    char *out;
+
+    if(word == NULL || strchr(word, '$') == NULL)
+    {
+        return word;
+    }
+
+    out = (char *) arenaAlloc(sh->arena, expandWord(sh, word, NULL) + 1);
+    expandWord(sh, word, out);
+
+    return out;
+}
+
+
+// *****************************************************************************
+//
+// static int expandWords(struct Shell *sh, char *words[], char ***argv)
+//
+// Purpose: Expands a NULL-terminated word list into a new NULL-terminated
+//          array in the statement arena. A word that is exactly $@ or $*
+//          becomes one word per positional parameter. Returns the number of
+//          words, or -1 if there would be too many.
+//
+// *****************************************************************************
+//
+static int expandWords(struct Shell *sh, char *words[], char ***argv)
+{
+    int count = 0;          // Number of expanded words
+    int i;
+    int j;
+
+    // Count first so the array can be allocated in one piece.
+    //
+    for(i = 0; words[i] != NULL; i++)
+    {
+        if(strcmp(words[i], "$@") == 0 || strcmp(words[i], "$*") == 0)
+        {
+            count += sh->numPosArgs > 0 ? sh->numPosArgs - 1 : 0;
+        }
+        else
+        {
+            count++;
+        }
+    }
+    if(count >= MAX_ARGS)
+    {
+        fprintf(stderr, "smallsh: too many arguments\n");
+        return -1;
+    }
+
+    *argv = (char **) arenaAlloc(sh->arena, (count + 1) * sizeof(char *));
+
+    count = 0;
+    for(i = 0; words[i] != NULL; i++)
+    {
+        if(strcmp(words[i], "$@") == 0 || strcmp(words[i], "$*") == 0)
+        {
+            for(j = 1; j < sh->numPosArgs; j++)
+            {
+                (*argv)[count++] = sh->posArgs[j];
+            }
+        }
+        else
+        {
+            (*argv)[count++] = expand(sh, words[i]);
+        }
+    }
+    (*argv)[count] = NULL;
+
+    return count;
+}
+
+
+// *****************************************************************************
+//
+// static int isAssignment(const char *word)
+//
+// Purpose: Tells whether a word has the form NAME=value.
+//
+// *****************************************************************************
+//
+static int isAssignment(const char *word)
+{
+    const char *p = word;
+
+    if(!(*p == '_' || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+    {
+        return 0;
+    }
+    while(*p == '_' || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+          (*p >= '0' && *p <= '9'))
+    {
+        p++;
+    }
+
+    return *p == '=';
+}
+
+
+// *****************************************************************************
+//
+// static struct Func *findFunc(struct Shell *sh, const char *name)
+//
+// Purpose: Looks up a shell function by name.
+//
+// *****************************************************************************
+//
+static struct Func *findFunc(struct Shell *sh, const char *name)
+{
+    struct Func *f;
+
+    for(f = sh->funcs; f != NULL; f = f->next)
+    {
+        if(strcmp(f->name, name) == 0)
+        {
+            return f;
+        }
+    }
+
+    return NULL;
+}
+
+
+// *****************************************************************************
+//
+// static int defineFunc(struct Shell *sh, struct AstNode *node)
+//
+// Purpose: Defines (or redefines) a shell function. The body text is copied
+//          and parsed once into an arena owned by the function, so calling
+//          the function later costs no parsing or allocation.
+//
+// *****************************************************************************
+//
+static int defineFunc(struct Shell *sh, struct AstNode *node)
+{
+    struct Func *f = findFunc(sh, node->name);
+    char errMsg[128];
+
+    if(f == NULL)
+    {
+        f = (struct Func *) malloc(sizeof(struct Func));
+        if(f == NULL)
+        {
+            perror("Function allocation failed");
+            exit(1);
+        }
+        f->name = strdup(node->name);
+        f->src = NULL;
+        f->busy = 0;
+        arenaInit(&f->arena);
+        f->next = sh->funcs;
+        sh->funcs = f;
+    }
+    else if(f->busy > 0)
+    {
+        fprintf(stderr, "smallsh: %s: cannot redefine a running function\n", f->name);
+        return 1;
+    }
+
+    free(f->src);
+    arenaReset(&f->arena);
+    f->src = strndup(node->src, node->srcLen);
+    if(f->name == NULL || f->src == NULL)
+    {
+        perror("Function allocation failed");
+        exit(1);
+    }
+
+    // The body parsed once already as part of the statement, so this cannot
+    // fail; check anyway rather than run a half-built tree.
+    //
+    if(parseScript(f->src, node->srcLen, &f->arena, &f->body, errMsg,
+                   sizeof(errMsg)) != PARSE_OK)
+    {
+        fprintf(stderr, "smallsh: %s\n", errMsg);
+        f->body = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static int callFunc(struct Shell *sh, struct Func *f, char *argv[], int argc)
+//
+// Purpose: Runs a shell function with argv as its positional parameters.
+//
+// *****************************************************************************
+//
+static int callFunc(struct Shell *sh, struct Func *f, char *argv[], int argc)
+{
+    char **savedArgs = sh->posArgs;       // Caller's positional parameters
+    int savedNumArgs = sh->numPosArgs;
+    int savedLoopDepth = sh->loopDepth;   // break/continue stop at a function
+    int status;
+
+    if(sh->funcDepth >= MAX_FUNC_DEPTH)
+    {
+        fprintf(stderr, "smallsh: %s: maximum function nesting exceeded\n", f->name);
+        return 1;
+    }
+
+    sh->posArgs = argv;
+    sh->numPosArgs = argc;
+    sh->loopDepth = 0;
+    sh->funcDepth++;
+    f->busy++;
+
+    status = evalList(sh, f->body);
+    if(sh->ctl == CTL_RETURN)
+    {
+        sh->ctl = CTL_NONE;
+    }
+
+    f->busy--;
+    sh->funcDepth--;
+    sh->loopDepth = savedLoopDepth;
+    sh->numPosArgs = savedNumArgs;
+    sh->posArgs = savedArgs;
+
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// static int runExternal(struct Shell *sh, char *userArgs[], char *redirIn,
+//                        char *redirOut, char bg)
+//
+// Purpose: Forks and execs a program, in the foreground or the background.
+//          Returns the program's exit code (0 for a background program).
+//
+// *****************************************************************************
+//
+static int runExternal(struct Shell *sh, char *userArgs[], char *redirIn,
+                       char *redirOut, char bg)
+{
+    int   fdIn;                          // File descriptor to hold new stdin
+    int   fdOut;                         // File descriptor to hold new stdout
+    pid_t pid;                           // Currently processed PID
+    char  **env;                         // Environment for the program
+
+    // If the user did not specify a file to use as redirected input for a
+    // background process, we have to set /dev/null as the redirected input.
+    //
+    if(bg == 1 && redirIn == NULL)
+    {
+        redirIn = "/dev/null";
+    }
+
+    // First program: set up the status ring it will inherit. Then build
+    // its environment from the shell's variables, here in the parent so
+    // it is only rebuilt when a variable has changed.
+    //
+    createStatusRing(sh);
+    env = varEnviron(sh);
+
+    // Fork this shell. The fork() function will return -1 if an
+    // error was encountered, or 0 if the currently running process
+    // is the one the parent forked, or the PID of the fork()'d
+    // child process if the current process is the child's parent.
+    //
+    // vfork() rather than fork(): the child borrows the shell's memory
+    // until it execs instead of copying its page tables, which was most
+    // of the cost of starting a program. The parent is suspended until
+    // then. So the child only touches its own descriptors, signal
+    // dispositions and an empty stdout buffer, and leaves with _exit().
+    //
+    fflush(stdout);
+    pid = vfork();
+
+    // If anything went awry when forking this shell, exit with
+    // a descriptive error.
+    //
+    if((int)pid < 0)
+    {
+        perror("Fork failed.");
+        exit(1);
+    }
+    else if((int)pid == 0)
+    {
+        // This section of the code will only be seen by the fork()'d
+        // child process.
+
+        // SIGINT is ignored in the parent process. Now that we're in
+        // the child process, we need to set it back to normal (SIG_DFL).
+        //
+        struct sigaction saInt;
+        saInt.sa_handler = SIG_DFL;
+        saInt.sa_flags = 0;
+
+        // If there was an error setting up the sigaction(), exit with
+        // a descriptive error.
+        //
+        if(sigaction(SIGINT, &saInt, 0) == -1)
+        {
+            perror("SIGINT ignore sigaction failed");
+            fflush(stdout);
+            _exit(1);
+        }
+
+        // If the command was put in the background (this was set when
+        // user input was parsed and a "&" was detected at the end of the
+        // command line), report the background PID.
+        //
+        if(bg == 1)
+        {
+            printf("background pid is %d\n", (int)getpid());
+            fflush(stdout);
+        }
+
+        // If the user entered a file for stdin redirection, reassign
+        // stdin to that file.
+        //
+        if(redirIn != NULL)
+        {
+            // Open the new stdin file as read-only.
+            //
+            fdIn = open(redirIn, O_RDONLY);
+
+            // If an error was encountered, exit with a descriptive
+            // error message.
+            //
+            if(fdIn < 0)
+            {
+                perror("Failed to open file for redirected input");
+                fflush(stdout);
+                _exit(1);
+            }
+
+            // Duplicate stdin on the new stdin file descriptor. If an
+            // error is encountered, exit with a descriptive error message.
+            //
+            if(dup2(fdIn, STDIN_FILENO) == -1)
+            {
+                perror("Stdin dup2()");
+                fflush(stdout);
+                _exit(1);
+            }
+
+            // It seems counterintuitive, but now that we have
+            // duplcated the stdin file descriptor to a different
+            // file descriptor, we can close out the new stdin
+            // descriptor file. It's not needed anymore.
+            //
+            close(fdIn);
+        }
+
+        // If the user entered a file for stdout redirection, reassign
+        // stdout to that file.
+        //
+        if(redirOut != NULL)
+        {
+            // Open the new stdout file. Set permissions to read/write by
+            // the user, and set up the file to be write-only from this
+            // program. If the file does not exist, create it; if it does
+            // exist, truncate it.
+            //
+            fdOut = open(redirOut, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+
+            // If an error was encountered, exit with a descriptive
+            // error message.
+            //
+            if(fdOut < 0)
+            {
+                perror("Failed to open file for redirected output");
+                fflush(stdout);
+                _exit(1);
+            }
+
+            // Unlike with stdin, there is no controversy whatsoever with using
+            // fflush() with stdout. Similar to stdin, it's best to flush
+            // out stdout before shifting it to a different file descriptor.
+            //
+            fflush(stdout);
+            if(dup2(fdOut, STDOUT_FILENO) == -1)
+            {
+                perror("Stdout dup2()");
+                fflush(stdout);
+                _exit(1);
+            }
+
+            // Now that we have duplcated the stdout file
+            // descriptor to a different file descriptor, we can
+            // close out the new stdout descriptor file. It's not
+            // needed anymore.
+            //
+            close(fdOut);
+        }
+
+        // Exec the command line entered by the user. This will replace
+        // the existing fork()'d process with the new command's process.
+        //
+        traceEnd("first exec");
+        execvpe(userArgs[0], userArgs, env);
+
+        // If everything goes well, we will never get here. A successful
+        // exec() ends the program here and never returns.
+        //
+        // If an error occurred, as always exit with a descriptive message.
+        //
+        // The child leaves with _exit() here and above, not exit(). The
+        // script being read shares its file offset with this child, and
+        // exit() would seek it back to where the parent's stdio buffer
+        // ends, making the parent read lines it has already run.
+        //
+        perror("Exec failed");
+        fflush(stdout);
+        _exit(1);
+    }
+
+    // This section of the code will only be seen by the parent
+    // of the fork()'d child process. The child reported the end of
+    // startup, if it was being traced.
+    //
+    traceEnd(NULL);
+
+    // SIGINT is ignored in the parent process (SIG_IGN). We do not
+    // want SIGINT to be ignored in child processes, though, so
+    // similar code in the child process section above changes this
+    // signal handling back to its defaults (SIG_DFL).
+    //
+    struct sigaction saInt;
+    saInt.sa_handler = SIG_IGN;
+    saInt.sa_flags = 0;
+
+    // If there was an error setting up the sigaction(), exit with
+    // a descriptive error.
+    //
+    if(sigaction(SIGINT, &saInt, 0) == -1)
+    {
+        perror("SIGINT ignore sigaction failed");
+        exit(1);
+    }
+
+    // If we backgrounded the process, track it in the process
+    // linked list. The fork() process returned the child's PID to us
+    // (it's what got us here), so plug that into a new node along with
+    // the command line it was started with. The stats socket thread may
+    // be reading the list, so hold the job lock while changing it.
+    //
+    if(bg == 1)
+    {
+        lockJobs();
+        sh->head = addNode(pid, userArgs, sh->head);
+        sh->numNodes++;
+        unlockJobs();
+
+        return 0;
+    }
+
+    // We did not spawn a background process (those are all handled
+    // separately through the linked list that was started above),
+    // so block until the current FOREground process ends. Write its
+    // exit status data to the global pstatus variable so other
+    // functions can glean information from it.
+    //
+    waitpid(pid, &pstatus, 0);
+
+    // A foreground program killed by ^C stops any loop it was part of,
+    // the same way it would in a login shell.
+    //
+    if(WIFSIGNALED(pstatus) && WTERMSIG(pstatus) == SIGINT)
+    {
+        sh->ctl = CTL_ABORT;
+    }
+
+    return exitCode(pstatus);
+}
+
+
+// *****************************************************************************
+//
+// static int runSimple(struct Shell *sh, struct AstNode *node)
+//
+// Purpose: Runs a simple command: variable assignments, a built-in, a shell
+//          function, or an external program, in that order of preference.
+//
+// *****************************************************************************
+//
+static int runSimple(struct Shell *sh, struct AstNode *node)
+{
+    struct ArenaMark mark = arenaMark(sh->arena); // Scratch memory to release
+    char **userArgs;                              // Expanded arguments
+    int numArgs;                                  // Number of arguments
+    struct Func *f;                               // Function being called
+    char *eq;                                     // '=' of an assignment
+    int status = 0;                               // Exit code of the command
+    int i;
+
+    // Array that will hold pointers to our builtin functions. Initially set
+    // this up to be a generic_fp type array. Cast all functions saved in the
+    // array to be generic_fp as well. When the functions are called, cast
+    // them to the correct 'builtin_[no]arg' type, listed in smallsh.h.
+    //
+    generic_fp builtins[] = { (generic_fp)myCd, (generic_fp)myStatus,
+                              (generic_fp)myJobs };
+
+    numArgs = expandWords(sh, node->words, &userArgs);
+    if(numArgs < 0)
+    {
+        status = 1;
+    }
+    else if(numArgs == 0)
+    {
+        // Nothing to run (only redirections).
+        //
+        status = 0;
+    }
+    else if(isAssignment(userArgs[0]))
+    {
+        // NAME=value words set (exported) shell variables. A command made
+        // only of assignments does nothing else.
+        //
+        for(i = 0; i < numArgs && isAssignment(userArgs[i]); i++)
+        {
+            eq = strchr(userArgs[i], '=');
+            setVar(sh, userArgs[i], (size_t)(eq - userArgs[i]), eq + 1);
+        }
+        if(i < numArgs)
+        {
+            fprintf(stderr, "smallsh: %s: command prefixes are not supported\n",
+                    userArgs[0]);
+            status = 1;
+        }
+    }
+    else if(strcmp(userArgs[0], "cd") == 0)                // "cd"
+    {
+        status = ((builtin_arg_shell)builtins[0])(sh, userArgs, numArgs); // run myCd()
+    }
+    else if(strcmp(userArgs[0], "status") == 0)            // "status"
+    {
+        ((builtin_arg_proc)builtins[1])(pstatus);          // run myStatus()
+    }
+    else if(strcmp(userArgs[0], "jobs") == 0)              // "jobs"
+    {
+        status = ((builtin_arg_shell)builtins[2])(sh, userArgs, numArgs); // run myJobs()
+    }
+    else if(strcmp(userArgs[0], "exit") == 0)              // "exit"
+    {
+        // Set the continuation flag to 'n' so the shell can exit.
+        //
+        sh->cont = 'n';
+        sh->exitStatus = numArgs > 1 ? atoi(userArgs[1]) : EXIT_SUCCESS;
+    }
+    else if(strcmp(userArgs[0], "true") == 0)              // "true"
+    {
+        status = 0;
+    }
+    else if(strcmp(userArgs[0], "false") == 0)             // "false"
+    {
+        status = 1;
+    }
+    else if(strcmp(userArgs[0], "break") == 0 ||           // "break"
+            strcmp(userArgs[0], "continue") == 0)          // "continue"
+    {
+        if(sh->loopDepth == 0)
+        {
+            fprintf(stderr, "smallsh: %s: only meaningful in a loop\n", userArgs[0]);
+            status = 1;
+        }
+        else
+        {
+            sh->ctl = userArgs[0][0] == 'b' ? CTL_BREAK : CTL_CONTINUE;
+        }
+    }
+    else if(strcmp(userArgs[0], "return") == 0)            // "return"
+    {
+        if(sh->funcDepth == 0)
+        {
+            fprintf(stderr, "smallsh: return: can only return from a function\n");
+            status = 1;
+        }
+        else
+        {
+            sh->ctl = CTL_RETURN;
+            status = numArgs > 1 ? atoi(userArgs[1]) : sh->lastStatus;
+        }
+    }
+    else if((f = findFunc(sh, userArgs[0])) != NULL)
+    {
+        status = callFunc(sh, f, userArgs, numArgs);
+    }
+    else
+    {
+        status = runExternal(sh, userArgs, expand(sh, node->redirIn),
+                             expand(sh, node->redirOut), node->bg);
+    }
+
+    arenaRelease(sh->arena, mark);
+
+    sh->lastStatus = status;
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// static int runFor(struct Shell *sh, struct AstNode *node)
+//
+// Purpose: Runs a for loop, setting the loop variable to each item in turn.
+//
+// *****************************************************************************
+//
+static int runFor(struct Shell *sh, struct AstNode *node)
+{
+    struct ArenaMark mark = arenaMark(sh->arena); // Scratch memory to release
+    char **items;                                 // Expanded loop items
+    int numItems;                                 // Number of loop items
+    int status = 0;                               // Exit code of the last body
+    int i;
+
+    if(node->hasIn)
+    {
+        numItems = expandWords(sh, node->words, &items);
+        if(numItems < 0)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        // No "in" list: loop over the positional parameters.
+        //
+        items = sh->numPosArgs > 0 ? sh->posArgs + 1 : NULL;
+        numItems = sh->numPosArgs > 0 ? sh->numPosArgs - 1 : 0;
+    }
+
+    sh->loopDepth++;
+    for(i = 0; i < numItems; i++)
+    {
+        setVar(sh, node->name, strlen(node->name), items[i]);
+        status = evalList(sh, node->body);
+        if(sh->ctl == CTL_CONTINUE)
+        {
+            sh->ctl = CTL_NONE;
+        }
+        else if(sh->ctl == CTL_BREAK)
+        {
+            sh->ctl = CTL_NONE;
+            break;
+        }
+        if(stopping(sh))
+        {
+            break;
+        }
+    }
+    sh->loopDepth--;
+
+    arenaRelease(sh->arena, mark);
+
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// static int runWhile(struct Shell *sh, struct AstNode *node)
+//
+// Purpose: Runs a while loop (or an until loop, which runs while its
+//          condition fails).
+//
+// *****************************************************************************
+//
+static int runWhile(struct Shell *sh, struct AstNode *node)
+{
+    int status = 0;         // Exit code of the last body
+    int cond;               // Exit code of the condition
+
+    sh->loopDepth++;
+    for(;;)
+    {
+        cond = evalList(sh, node->cond);
+        if(sh->ctl == CTL_CONTINUE)
+        {
+            sh->ctl = CTL_NONE;
+            continue;
+        }
+        else if(sh->ctl == CTL_BREAK)
+        {
+            sh->ctl = CTL_NONE;
+            break;
+        }
+        if(stopping(sh) || (cond == 0) != (node->type == N_WHILE))
+        {
+            break;
+        }
+
+        status = evalList(sh, node->body);
+        if(sh->ctl == CTL_CONTINUE)
+        {
+            sh->ctl = CTL_NONE;
+        }
+        else if(sh->ctl == CTL_BREAK)
+        {
+            sh->ctl = CTL_NONE;
+            break;
+        }
+        if(stopping(sh))
+        {
+            break;
+        }
+    }
+    sh->loopDepth--;
+
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// static int evalNode(struct Shell *sh, struct AstNode *node)
+//
+// Purpose: Runs one command (simple, compound, or && / ||) and returns its
+//          exit code.
+//
+// *****************************************************************************
+//
+static int evalNode(struct Shell *sh, struct AstNode *node)
+{
+    int status = 0;
+
+    switch(node->type)
+    {
+        case N_CMD:
+            status = runSimple(sh, node);
+            break;
+        case N_AND:
+        case N_OR:
+            // The right side only runs if the left side succeeded (&&) or
+            // failed (||).
+            //
+            status = evalNode(sh, node->left);
+            if(!stopping(sh) && (status == 0) == (node->type == N_AND))
+            {
+                status = evalNode(sh, node->right);
+            }
+            break;
+        case N_IF:
+            status = evalList(sh, node->cond);
+            if(stopping(sh))
+            {
+                break;
+            }
+            if(status == 0)
+            {
+                status = evalList(sh, node->body);
+            }
+            else if(node->elseBody != NULL)
+            {
+                status = evalList(sh, node->elseBody);
+            }
+            else
+            {
+                status = 0;
+            }
+            break;
+        case N_WHILE:
+        case N_UNTIL:
+            status = runWhile(sh, node);
+            break;
+        case N_FOR:
+            status = runFor(sh, node);
+            break;
+        case N_GROUP:
+            status = evalList(sh, node->body);
+            break;
+        case N_FUNCDEF:
+            status = defineFunc(sh, node);
+            break;
+    }
+
+    sh->lastStatus = status;
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// static int evalList(struct Shell *sh, struct AstNode *list)
+//
+// Purpose: Runs each command of a list in turn, stopping early for exit,
+//          break, continue, return or an interrupt.
+//
+// *****************************************************************************
+//
+static int evalList(struct Shell *sh, struct AstNode *list)
+{
+    int status = 0;
+
+    for(; list != NULL; list = list->next)
+    {
+        status = evalNode(sh, list);
+        if(stopping(sh))
+        {
+            break;
+        }
+    }
+
+    return status;
+}
+
+
+// *****************************************************************************
+//
+// int evalTree(struct Shell *sh, struct AstNode *tree)
+//
+// Purpose: Runs a top-level statement. An interrupt only cancels the
+//          statement it happened in.
+//
+// *****************************************************************************
+//
+int evalTree(struct Shell *sh, struct AstNode *tree)
+{
+    int status = evalList(sh, tree);
+
+    sh->ctl = CTL_NONE;
+
+    return status;
+}
@@ -18,24 +18,35 @@
 
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include "smallsh.h"
 
 
+extern char **environ;
+
+int pstatus; // holds whatever status happens to be the latest
+
+static int tracing;                  // Startup is being traced (-T)
+static struct timespec traceZero;    // When main() was entered
+
+
 // *****************************************************************************
 // 
-// void myCd(char *userArgs[], int numArgs)
+// int myCd(struct Shell *sh, char *userArgs[], int numArgs)
 //
 // Purpose: Built-in cd command, light imitation of UNIX cd.
 //
 // *****************************************************************************
 //
-void myCd(char *userArgs[], int numArgs)
+int myCd(struct Shell *sh, char *userArgs[], int numArgs)
 {
 
-    char *homeDir;    // Holds the user's home directory
+    const char *homeDir; // Holds the user's home directory
+    int result = -1;  // Return value of chdir()
 
     // If there's 1 arg on the command line, the user's home directory is requested.
     // If there are two args, the user specified a directory to go to.
@@ -44,16 +55,32 @@ void myCd(char *userArgs[], int numArgs)
     switch(numArgs)
     {
         case 1:
-            homeDir = getenv("HOME");  // grab the user's home dir envar
-            chdir(homeDir);            // change to the directory
+            homeDir = getVar(sh, "HOME", 4); // grab the user's home dir var
+            if(homeDir == NULL || homeDir[0] == '\0')
+            {
+                printf("Invalid: HOME is not set.\n");
+                return 1;
+            }
+            result = chdir(homeDir);   // change to the directory
             break;
         case 2:
-            chdir(userArgs[1]);        // 2nd arg is the directory to go to
-            break;                     // change to the directory
+            result = chdir(userArgs[1]); // 2nd arg is the directory to go to
+            break;                       // change to the directory
         default:
             printf("Invalid: too many arguments to cd.\n");
+            return 1;
     }
 
+    // Report a failed chdir() so the user (and && / ||) can tell.
+    //
+    if(result == -1)
+    {
+        perror("cd");
+        return 1;
+    }
+
+    return 0;
+
 }
 
 
@@ -88,7 +115,127 @@ void myStatus(int pstatus)
 
 // *****************************************************************************
 // 
-// struct Node *addNode(int newPid, struct Node *head)
+// int exitCode(int status)
+//
+// Purpose: Turns a waitpid() status into a shell exit code: the exit value
+//          of a process that exited, or 128 + signal number of one that was
+//          killed.
+//
+// *****************************************************************************
+//
+int exitCode(int status)
+{
+    if(WIFEXITED(status))
+    {
+        return WEXITSTATUS(status);
+    }
+    if(WIFSIGNALED(status))
+    {
+        return 128 + WTERMSIG(status);
+    }
+    return 1;
+}
+
+
+// *****************************************************************************
+// 
+// void traceStart(const struct timespec *start)
+//
+// Purpose: Turns on startup tracing.
+//
+// *****************************************************************************
+//
+void traceStart(const struct timespec *start)
+{
+    traceZero = *start;
+    tracing = 1;
+}
+
+
+// *****************************************************************************
+// 
+// void tracePoint(const char *fmt, ...)
+//
+// Purpose: Prints one startup trace line: elapsed milliseconds and a step.
+//
+// *****************************************************************************
+//
+void tracePoint(const char *fmt, ...)
+{
+    struct timespec now;      // Current time
+    va_list ap;               // Arguments for fmt
+
+    if(!tracing)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    fprintf(stderr, "smallsh: startup %8.3f ms: ",
+            (now.tv_sec - traceZero.tv_sec) * 1e3 +
+            (now.tv_nsec - traceZero.tv_nsec) / 1e6);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+
+// *****************************************************************************
+// 
+// void traceEnd(const char *what)
+//
+// Purpose: Reports the end of startup and stops tracing.
+//
+// *****************************************************************************
+//
+void traceEnd(const char *what)
+{
+    if(what != NULL)
+    {
+        tracePoint("%s", what);
+    }
+    tracing = 0;
+}
+
+
+// *****************************************************************************
+// 
+// static int packArgs(char *dst, size_t size, char *userArgs[])
+//
+// Purpose: Copies an argument list into a fixed-size buffer, one argument
+//          after another with NUL separators. Arguments that do not fit are
+//          dropped (the last one may be cut short). Returns how many
+//          arguments were stored.
+//
+// *****************************************************************************
+//
+static int packArgs(char *dst, size_t size, char *userArgs[])
+{
+    size_t used = 0;          // Bytes of dst filled so far
+    size_t len;               // Length of the current argument
+    int count = 0;            // Arguments stored
+
+    while(userArgs[count] != NULL && used < size)
+    {
+        len = strlen(userArgs[count]);
+        if(len > size - used - 1)
+        {
+            len = size - used - 1;
+        }
+        memcpy(dst + used, userArgs[count], len);
+        dst[used + len] = '\0';
+        used += len + 1;
+        count++;
+    }
+
+    return count;
+}
+
+
+// *****************************************************************************
+// 
+// struct Node *addNode(int newPid, char *userArgs[], struct Node *head)
 //
 // Purpose: Adds a background process PID node to the linked list that tracks
 //          background processes.
@@ -96,13 +243,22 @@ void myStatus(int pstatus)
 // *****************************************************************************
 //
 
-struct Node *addNode(int newPid, struct Node *head) {
+struct Node *addNode(int newPid, char *userArgs[], struct Node *head) {
 
     // Set up a new node to add to the background PID node list.
     // 
     struct Node *newNode;      
     newNode = (struct Node *) malloc(sizeof(struct Node));
+    if(newNode == NULL)
+    {
+        perror("Background process list allocation failed");
+        exit(1);
+    }
     newNode->pid = newPid;
+    clock_gettime(CLOCK_REALTIME, &newNode->start);
+    newNode->argc = packArgs(newNode->argv, sizeof(newNode->argv), userArgs);
+    newNode->progress[0] = '\0';
+    newNode->result[0] = '\0';
 
     // Add the new node to the head of the list for simplicity. (It's 
     // always harder adding nodes to the end of the list.)
@@ -119,86 +275,503 @@ struct Node *addNode(int newPid, struct Node *head) {
 
 // *****************************************************************************
 // 
-// struct Node *clearChildren(struct Node *head, int *numNodes)
+// void clearChildren(struct Shell *sh)
 //
-// Purpose: Reaps zombies from background processes. Removes nodes of reaped
-//          zombies afterward.
+// Purpose: Reaps zombies from background processes, then reports each
+//          finished process that has not been reported yet. Finished
+//          processes stay in the shell's ring of finished jobs for 'jobs'.
 //
 // *****************************************************************************
 //
-struct Node *clearChildren(struct Node *head, int *numNodes) {
+void clearChildren(struct Shell *sh) {
 
-    int wpid;                 // PID returned by waitpid()
-    struct Node *prev;        // Previous node in the linked list
-    struct Node *curr;        // Current node in the linked list
+    struct JobRecord *rec;    // Finished job being reported
+    unsigned int i;           // Ring position being checked
+    unsigned int oldest;      // Oldest ring position still held
 
-    prev = NULL;              // Start off at the beginning (no previous node)
-    curr = head;              // Start at the head node
+    lockJobs();
+
+    // Pick up progress reports, then reap whatever has finished. (The stats
+    // socket thread may already have done this for some of them; either way
+    // they end up in the ring.)
+    //
+    drainStatus(sh);
+    reapJobs(sh);
 
-    // Only move head if it's being freed! Otherwise, maintain head.
-    // (Head = no prev node.)
-    
-    // For each node in the list...
+    // Walk the ring from oldest to newest and report the jobs nobody has
+    // heard about yet.
     //
-    while(curr != NULL)
+    oldest = sh->done.count > JOB_RING_SIZE ? sh->done.count - JOB_RING_SIZE : 0;
+    for(i = oldest; i != sh->done.count; i++)
     {
-        // Try to reap the zombie from the process. Assign the return value
-        // to wpid and use that to determine how to move forward. Do not wait
-        // for a zombie to be reaped; try it and move along (WNOHANG).
+        rec = &sh->done.rec[i % JOB_RING_SIZE];
+        if(rec->notified)
+        {
+            continue;
+        }
+        rec->notified = 1;
+
+        // Update the global pstatus variable to contain exit data for the
+        // process, so 'status' reports it.
         //
-        // Upon success, update the global pstatus variable to contain exit
-        // data for the process.
+        pstatus = rec->status;
+
+        // Report which PID was reaped.
         //
-        wpid = (int)waitpid(curr->pid, &pstatus, WNOHANG);
+        printf("background pid %d is done: ", (int)rec->pid);
 
-        // If we succeeded in reaping a zombie...
+        // Check the pstatus variable for exit/termination information
+        // and report it.
         //
-        if(wpid > 0)
+        myStatus(pstatus);
+    }
+
+    unlockJobs();
+}
+
+
+// *****************************************************************************
+// 
+// void arenaInit(struct Arena *arena)
+//
+// Purpose: Starts an arena with no blocks. The first block is allocated by
+//          the first call to arenaAlloc().
+//
+// *****************************************************************************
+//
+void arenaInit(struct Arena *arena)
+{
+    arena->curr = NULL;
+}
+
+
+// *****************************************************************************
+// 
+// void *arenaAlloc(struct Arena *arena, size_t size)
+//
+// Purpose: Bump-allocates zeroed memory from the current block, chaining on
+//          a new block when the current one is full.
+//
+// *****************************************************************************
+//
+void *arenaAlloc(struct Arena *arena, size_t size)
+{
+    struct ArenaBlock *block = arena->curr;
+    size_t blockSize;
+    void *mem;
+
+    // Keep every allocation aligned for any pointer or integer type.
+    //
+    size = (size + 15) & ~(size_t)15;
+
+    // Not enough room (or no block yet)? Chain on a new block, big enough
+    // for this allocation if it is larger than the default block size.
+    //
+    if(block == NULL || block->size - block->used < size)
+    {
+        blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = (struct ArenaBlock *) malloc(sizeof(struct ArenaBlock) + blockSize);
+        if(block == NULL)
         {
-            // Report which PID was reaped.
-            //
-            printf("background pid %d is done: ", wpid);
-
-            // Check the pstatus variable for exit/termination information
-            // and report it.
-            //
-            myStatus(pstatus);
-
-            // Head is being freed! Move head to head->next and free curr. The
-            // PID that was in curr will not be checked again.
-            //
-            if(prev == NULL)
-            {
-                head = head->next;
-                free(curr);
-                curr = head;
-            }
-            // Head is not being freed. Point prev->next to curr->next and
-            // free curr.
-            //
-            else{
-                prev->next = curr->next;
-                free(curr);
-                curr = prev->next;
-            }
+            perror("Arena allocation failed");
+            exit(1);
+        }
+        block->prev = arena->curr;
+        block->size = blockSize;
+        block->used = 0;
+        arena->curr = block;
+    }
+
+    mem = block->data + block->used;
+    block->used += size;
+    memset(mem, 0, size);
+
+    return mem;
+}
+
+
+// *****************************************************************************
+// 
+// char *arenaStrndup(struct Arena *arena, const char *str, size_t len)
+//
+// Purpose: Copies len characters of str into the arena and terminates them.
+//
+// *****************************************************************************
+//
+char *arenaStrndup(struct Arena *arena, const char *str, size_t len)
+{
+    char *copy = (char *) arenaAlloc(arena, len + 1);
+
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    return copy;
+}
+
+
+// *****************************************************************************
+// 
+// struct ArenaMark arenaMark(struct Arena *arena)
+//
+// Purpose: Records the current block and fill level.
+//
+// *****************************************************************************
+//
+struct ArenaMark arenaMark(struct Arena *arena)
+{
+    struct ArenaMark mark;
+
+    mark.block = arena->curr;
+    mark.used = arena->curr != NULL ? arena->curr->used : 0;
+
+    return mark;
+}
+
+
+// *****************************************************************************
+// 
+// void arenaRelease(struct Arena *arena, struct ArenaMark mark)
+//
+// Purpose: Frees blocks chained on after the mark and rewinds the marked
+//          block to its recorded fill level.
+//
+// *****************************************************************************
+//
+void arenaRelease(struct Arena *arena, struct ArenaMark mark)
+{
+    struct ArenaBlock *prev;
+
+    while(arena->curr != mark.block)
+    {
+        prev = arena->curr->prev;
+        free(arena->curr);
+        arena->curr = prev;
+    }
+
+    if(arena->curr != NULL)
+    {
+        arena->curr->used = mark.used;
+    }
+}
+
 
-            // One less PID to process. Keep count.
-            //
-            (*numNodes)--;
+// *****************************************************************************
+// 
+// void arenaReset(struct Arena *arena)
+//
+// Purpose: Releases everything in the arena but keeps its first block, so a
+//          shell running one statement after another does not go back to
+//          malloc() for every statement.
+//
+// *****************************************************************************
+//
+void arenaReset(struct Arena *arena)
+{
+    struct ArenaMark mark;
+
+    // Find the first (oldest) block.
+    //
+    mark.block = arena->curr;
+    while(mark.block != NULL && mark.block->prev != NULL)
+    {
+        mark.block = mark.block->prev;
+    }
+    mark.used = 0;
+
+    arenaRelease(arena, mark);
+}
+
+
+// *****************************************************************************
+// 
+// void arenaFree(struct Arena *arena)
+//
+// Purpose: Frees every block in the arena.
+//
+// *****************************************************************************
+//
+void arenaFree(struct Arena *arena)
+{
+    struct ArenaMark mark = { NULL, 0 };
+
+    arenaRelease(arena, mark);
+}
+
+
+// *****************************************************************************
+// 
+// static size_t hashName(const char *name, size_t len)
+//
+// Purpose: FNV-1a hash of a variable name.
+//
+// *****************************************************************************
+//
+static size_t hashName(const char *name, size_t len)
+{
+    size_t h = 2166136261u;
+    size_t i;
+
+    for(i = 0; i < len; i++)
+    {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+
+// *****************************************************************************
+// 
+// static struct Var *findVar(struct VarTable *t, const char *name,
+//                            size_t nameLen)
+//
+// Purpose: Returns the slot holding a variable, or the empty slot it would
+//          go in. The table is never full, so the probe always ends.
+//
+// *****************************************************************************
+//
+static struct Var *findVar(struct VarTable *t, const char *name, size_t nameLen)
+{
+    size_t i = hashName(name, nameLen) & (t->size - 1);
+    struct Var *v;
+
+    for(;;)
+    {
+        v = &t->slot[i];
+        if(v->str == NULL ||
+           (v->nameLen == nameLen && memcmp(v->str, name, nameLen) == 0))
+        {
+            return v;
         }
-        // ...otherwise, just move to the next node in the list.
-        //
-        else   
+        i = (i + 1) & (t->size - 1);
+    }
+}
+
+
+// *****************************************************************************
+// 
+// static void resizeVars(struct VarTable *t, size_t size)
+//
+// Purpose: Moves the variables into a table of size slots (a power of two).
+//
+// *****************************************************************************
+//
+static void resizeVars(struct VarTable *t, size_t size)
+{
+    struct Var *old = t->slot;
+    size_t oldSize = t->size;
+    size_t i;
+
+    t->slot = (struct Var *) calloc(size, sizeof(struct Var));
+    if(t->slot == NULL)
+    {
+        perror("Variable table allocation failed");
+        exit(1);
+    }
+    t->size = size;
+
+    for(i = 0; i < oldSize; i++)
+    {
+        if(old[i].str != NULL)
+        {
+            *findVar(t, old[i].str, old[i].nameLen) = old[i];
+        }
+    }
+    free(old);
+}
+
+
+// *****************************************************************************
+// 
+// static void loadVars(struct Shell *sh)
+//
+// Purpose: Copies the environment the shell was started with into the
+//          variable table, the first time a variable is used.
+//
+// *****************************************************************************
+//
+static void loadVars(struct Shell *sh)
+{
+    struct VarTable *t = &sh->vars;
+    size_t size = 64;
+    size_t n = 0;
+    char **e;
+    char *eq;
+
+    if(t->slot != NULL)
+    {
+        return;
+    }
+
+    for(e = environ; *e != NULL; e++)
+    {
+        n++;
+    }
+    while(size < 2 * n)
+    {
+        size *= 2;
+    }
+    resizeVars(t, size);
+
+    // Like getenv(), the first of two entries with the same name wins.
+    //
+    for(e = environ; *e != NULL; e++)
+    {
+        eq = strchr(*e, '=');
+        if(eq != NULL && findVar(t, *e, (size_t)(eq - *e))->str == NULL)
         {
-            prev = curr;
-            curr = curr->next;
+            setVar(sh, *e, (size_t)(eq - *e), eq + 1);
         }
     }
+}
+
+
+// *****************************************************************************
+// 
+// const char *getVar(struct Shell *sh, const char *name, size_t nameLen)
+//
+// Purpose: Looks up a variable's value.
+//
+// *****************************************************************************
+//
+const char *getVar(struct Shell *sh, const char *name, size_t nameLen)
+{
+    struct Var *v;
+
+    loadVars(sh);
+    v = findVar(&sh->vars, name, nameLen);
+
+    return v->str != NULL ? v->str + nameLen + 1 : NULL;
+}
+
+
+// *****************************************************************************
+// 
+// void setVar(struct Shell *sh, const char *name, size_t nameLen,
+//             const char *value)
+//
+// Purpose: Sets a variable. A value that fits in the variable's string is
+//          copied in place, so a loop variable costs no allocation and does
+//          not invalidate the built environment.
+//
+// *****************************************************************************
+//
+void setVar(struct Shell *sh, const char *name, size_t nameLen,
+            const char *value)
+{
+    struct VarTable *t = &sh->vars;
+    size_t valueLen = strlen(value);
+    size_t need = nameLen + valueLen + 2;
+    struct Var *v;
+    char *str;
+
+    loadVars(sh);
+    v = findVar(t, name, nameLen);
+
+    if(v->str != NULL && need <= v->cap)
+    {
+        memcpy(v->str + nameLen + 1, value, valueLen + 1);
+        return;
+    }
+
+    // New variable, or a value too long for the old string. Keep the table
+    // at most half full.
+    //
+    if(v->str == NULL && 2 * (t->count + 1) > t->size)
+    {
+        resizeVars(t, 2 * t->size);
+        v = findVar(t, name, nameLen);
+    }
+
+    if(need < 32)
+    {
+        need = 32;
+    }
+    str = (char *) malloc(need);
+    if(str == NULL)
+    {
+        perror("Variable allocation failed");
+        exit(1);
+    }
+    memcpy(str, name, nameLen);
+    str[nameLen] = '=';
+    memcpy(str + nameLen + 1, value, valueLen + 1);
 
-    // Return the head pointer in case it is needed.
+    if(v->str == NULL)
+    {
+        t->count++;
+    }
+    free(v->str);
+    v->str = str;
+    v->nameLen = nameLen;
+    v->cap = need;
+
+    // The built environment points at the old string (or lacks the new
+    // variable).
     //
-    return head;
+    free(t->env);
+    t->env = NULL;
+}
+
+
+// *****************************************************************************
+// 
+// char **varEnviron(struct Shell *sh)
+//
+// Purpose: Returns the environment for a program, building it from the
+//          variable table if a variable was added or moved since last time.
+//
+// *****************************************************************************
+//
+char **varEnviron(struct Shell *sh)
+{
+    struct VarTable *t = &sh->vars;
+    size_t n = 0;
+    size_t i;
+
+    loadVars(sh);
+    if(t->env != NULL)
+    {
+        return t->env;
+    }
+
+    t->env = (char **) malloc((t->count + 1) * sizeof(char *));
+    if(t->env == NULL)
+    {
+        perror("Environment allocation failed");
+        exit(1);
+    }
+    for(i = 0; i < t->size; i++)
+    {
+        if(t->slot[i].str != NULL)
+        {
+            t->env[n++] = t->slot[i].str;
+        }
+    }
+    t->env[n] = NULL;
+
+    return t->env;
 }
 
 
+// *****************************************************************************
+// 
+// void freeVars(struct Shell *sh)
+//
+// Purpose: Frees every variable, the table and the built environment.
+//
+// *****************************************************************************
+//
+void freeVars(struct Shell *sh)
+{
+    struct VarTable *t = &sh->vars;
+    size_t i;
 
+    for(i = 0; i < t->size; i++)
+    {
+        free(t->slot[i].str);
+    }
+    free(t->slot);
+    free(t->env);
+    memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,839 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_io.c
+//
+//
+// Overview:
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language.
+//
+//    This file contains the I/O backends described in smallsh_io.h. The
+//    io_uring backend talks to the kernel with the raw system calls (there
+//    is no liburing dependency); the epoll backend turns readiness into the
+//    same completions.
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // accept4()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "smallsh_io.h"
+
+
+#define MAX_EVENTS   64                 // epoll events handled per wakeup
+#define URING_SQ     256                // Submission queue entries
+#define URING_CQ     4096               // Completion queue entries
+#define IO_BUFS      64                 // Read buffers in the pool
+#define IO_BGID      0                  // Buffer group of the pool
+#define OP_POLL      2                  // Tag of a read's readiness poll
+
+
+static int useUring;                    // io_uring backend in use
+
+// epoll backend
+//
+static int epollFd = -1;                // The epoll instance
+static char epollBuf[IO_BUF_SIZE];      // Buffer reads are made into
+
+// io_uring backend
+//
+static int ringFd = -1;                 // The io_uring instance
+static unsigned int *sqHead;            // Submission ring (shared)
+static unsigned int *sqTail;
+static unsigned int sqMask;
+static unsigned int *sqArray;
+static struct io_uring_sqe *sqes;       // Submission entries (shared)
+static unsigned int sqLocal;            // Our submission tail
+static unsigned int toSubmit;           // Entries queued since the last enter
+static unsigned int *cqHead;            // Completion ring (shared)
+static unsigned int *cqTail;
+static unsigned int cqMask;
+static struct io_uring_cqe *cqes;
+static char *pool;                      // Read buffer pool
+static int bufsFree = IO_BUFS;          // Buffers not promised to a read
+static struct IoWatch *waitHead;        // Reads waiting for a buffer
+static struct IoWatch *waitTail;
+
+
+// *****************************************************************************
+//
+// static int uringEnter(unsigned int submit, unsigned int wait)
+//
+// Purpose: Hands queued entries to the kernel and, if wait is non-zero,
+//          waits for that many completions.
+//
+// *****************************************************************************
+//
+static int uringEnter(unsigned int submit, unsigned int wait)
+{
+    int ret;
+
+    // Publish the new tail before the kernel looks at it.
+    //
+    __atomic_store_n(sqTail, sqLocal, __ATOMIC_RELEASE);
+
+    ret = (int) syscall(__NR_io_uring_enter, ringFd, submit, wait,
+                        wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if(ret >= 0)
+    {
+        toSubmit -= (unsigned int)ret < submit ? (unsigned int)ret : submit;
+    }
+    return ret;
+}
+
+
+// *****************************************************************************
+//
+// static struct io_uring_sqe *getSqe(void)
+//
+// Purpose: Returns a cleared submission entry, submitting what is queued if
+//          the ring is full.
+//
+// *****************************************************************************
+//
+static struct io_uring_sqe *getSqe(void)
+{
+    struct io_uring_sqe *sqe;
+
+    while(sqLocal - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) > sqMask)
+    {
+        if(uringEnter(toSubmit, 0) < 0 && errno != EINTR && errno != EAGAIN &&
+           errno != EBUSY)
+        {
+            perror("io_uring_enter()");
+            exit(1);
+        }
+    }
+
+    sqe = &sqes[sqLocal & sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[sqLocal & sqMask] = sqLocal & sqMask;
+    sqLocal++;
+    toSubmit++;
+
+    return sqe;
+}
+
+
+// *****************************************************************************
+//
+// static void provideBuffers(unsigned int bid, unsigned int count)
+//
+// Purpose: Gives count pool buffers, starting at bid, to the kernel to read
+//          into.
+//
+// *****************************************************************************
+//
+static void provideBuffers(unsigned int bid, unsigned int count)
+{
+    struct io_uring_sqe *sqe = getSqe();
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = (int)count;
+    sqe->addr = (uintptr_t)(pool + (size_t)bid * IO_BUF_SIZE);
+    sqe->len = IO_BUF_SIZE;
+    sqe->off = bid;
+    sqe->buf_group = IO_BGID;
+    sqe->user_data = 0;
+}
+
+
+// *****************************************************************************
+//
+// static void uringSubmit(struct IoWatch *w, int op)
+//
+// Purpose: Queues operation op (IO_READ, IO_WRITE or OP_POLL) on a watch.
+//
+// *****************************************************************************
+//
+static void uringSubmit(struct IoWatch *w, int op)
+{
+    struct io_uring_sqe *sqe = getSqe();
+
+    sqe->fd = w->fd;
+    sqe->user_data = (uintptr_t)w | (unsigned int)op;
+
+    if(op == OP_POLL)
+    {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLIN;
+    }
+    else if(op == IO_WRITE)
+    {
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->addr = (uintptr_t)w->wdata;
+        sqe->len = (unsigned int)w->wlen;
+        sqe->off = (uint64_t)-1;                // current position / stream
+    }
+    else if(w->accept)
+    {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+    }
+    else
+    {
+        // Let the kernel pick a pool buffer when data arrives.
+        //
+        sqe->opcode = IORING_OP_READ;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = IO_BGID;
+        sqe->len = IO_BUF_SIZE;
+        sqe->off = (uint64_t)-1;
+    }
+
+    w->inflight++;
+}
+
+
+// *****************************************************************************
+//
+// static void waitForBuffer(struct IoWatch *w)
+//
+// Purpose: Puts a watch's read at the end of the line for a buffer.
+//
+// *****************************************************************************
+//
+static void waitForBuffer(struct IoWatch *w)
+{
+    w->waiting = 1;
+    w->next = NULL;
+    if(waitTail != NULL)
+    {
+        waitTail->next = w;
+    }
+    else
+    {
+        waitHead = w;
+    }
+    waitTail = w;
+}
+
+
+// *****************************************************************************
+//
+// static void startRead(struct IoWatch *w)
+//
+// Purpose: Submits the read of a watch whose descriptor has data, or puts
+//          it in line for a buffer if every buffer is already promised to a
+//          submitted read or held by the shell. Counting them this way means
+//          the kernel always has a buffer for each read it holds, so a read
+//          never fails for want of one.
+//
+// *****************************************************************************
+//
+static void startRead(struct IoWatch *w)
+{
+    if(bufsFree > 0 && waitHead == NULL)
+    {
+        bufsFree--;
+        uringSubmit(w, IO_READ);
+        return;
+    }
+
+    waitForBuffer(w);
+}
+
+
+// *****************************************************************************
+//
+// static void bufferBack(void)
+//
+// Purpose: Counts a buffer as free again, after provideBuffers() has queued
+//          it or a read finished without taking one, and submits the first
+//          read waiting in line. The read is queued behind the provide, so
+//          the kernel has the buffer back by the time it gets the read.
+//
+// *****************************************************************************
+//
+static void bufferBack(void)
+{
+    struct IoWatch *w = waitHead;
+
+    bufsFree++;
+    if(w == NULL)
+    {
+        return;
+    }
+
+    waitHead = w->next;
+    if(waitHead == NULL)
+    {
+        waitTail = NULL;
+    }
+    w->waiting = 0;
+    bufsFree--;
+    uringSubmit(w, IO_READ);
+}
+
+
+// *****************************************************************************
+//
+// static int uringInit(void)
+//
+// Purpose: Sets up the io_uring instance, maps its rings and registers the
+//          read buffer pool. Returns -1 if the kernel does not allow any of
+//          it.
+//
+// *****************************************************************************
+//
+static int uringInit(void)
+{
+    struct io_uring_params p;
+    struct io_uring_cqe *cqe;
+    size_t sqSize;
+    size_t cqSize;
+    char *sqRing;
+    char *cqRing;
+    int res;
+
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = URING_CQ;
+    ringFd = (int) syscall(__NR_io_uring_setup, URING_SQ, &p);
+    if(ringFd < 0)
+    {
+        return -1;
+    }
+
+    // Map the submission and completion rings (one mapping on kernels
+    // that share it) and the submission entries.
+    //
+    sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if((p.features & IORING_FEAT_SINGLE_MMAP) && cqSize > sqSize)
+    {
+        sqSize = cqSize;
+    }
+    sqRing = (char *) mmap(NULL, sqSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    cqRing = sqRing;
+    if(sqRing != MAP_FAILED && !(p.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        cqRing = (char *) mmap(NULL, cqSize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    }
+    sqes = (struct io_uring_sqe *) mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                        ringFd, IORING_OFF_SQES);
+    pool = (char *) malloc((size_t)IO_BUFS * IO_BUF_SIZE);
+    if(sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED ||
+       pool == NULL)
+    {
+        // The process is about to fall back to epoll; whatever did get
+        // mapped is small and is not worth unwinding piece by piece.
+        //
+        close(ringFd);
+        ringFd = -1;
+        return -1;
+    }
+
+    sqHead = (unsigned int *)(sqRing + p.sq_off.head);
+    sqTail = (unsigned int *)(sqRing + p.sq_off.tail);
+    sqMask = *(unsigned int *)(sqRing + p.sq_off.ring_mask);
+    sqArray = (unsigned int *)(sqRing + p.sq_off.array);
+    cqHead = (unsigned int *)(cqRing + p.cq_off.head);
+    cqTail = (unsigned int *)(cqRing + p.cq_off.tail);
+    cqMask = *(unsigned int *)(cqRing + p.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe *)(cqRing + p.cq_off.cqes);
+    sqLocal = *sqTail;
+
+    // Register the buffer pool and make sure the kernel took it; provided
+    // buffers need Linux 5.7.
+    //
+    provideBuffers(0, IO_BUFS);
+    if(uringEnter(toSubmit, 1) < 0)
+    {
+        close(ringFd);
+        ringFd = -1;
+        return -1;
+    }
+    cqe = &cqes[*cqHead & cqMask];
+    res = cqe->res;
+    __atomic_store_n(cqHead, *cqHead + 1, __ATOMIC_RELEASE);
+    if(res < 0)
+    {
+        close(ringFd);
+        ringFd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static int uringWait(io_handler handler)
+//
+// Purpose: io_uring side of ioWait(): one io_uring_enter() submits what is
+//          queued and waits, then every completion is handled.
+//
+// *****************************************************************************
+//
+static int uringWait(io_handler handler)
+{
+    struct io_uring_cqe cqe;
+    struct IoWatch *w;
+    unsigned int head;
+    unsigned int bid;
+    char *data;
+    int op;
+
+    if(uringEnter(toSubmit, 1) < 0 && errno != EINTR && errno != EAGAIN &&
+       errno != EBUSY)
+    {
+        perror("io_uring_enter()");
+        return -1;
+    }
+
+    head = *cqHead;
+    while(head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+    {
+        // Copy the entry and hand its slot back before handling it.
+        //
+        cqe = cqes[head & cqMask];
+        head++;
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+        // Buffer registration and cancellations carry no watch.
+        //
+        if(cqe.user_data == 0)
+        {
+            continue;
+        }
+
+        w = (struct IoWatch *)(uintptr_t)(cqe.user_data & ~(uint64_t)3);
+        op = (int)(cqe.user_data & 3);
+        w->inflight--;
+
+        data = NULL;
+        bid = 0;
+        if(cqe.flags & IORING_CQE_F_BUFFER)
+        {
+            bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            data = pool + (size_t)bid * IO_BUF_SIZE;
+        }
+
+        if(w->fd < 0)
+        {
+            // Closed: the completion (most likely -ECANCELED) is dropped.
+            //
+        }
+        else if(op == OP_POLL)
+        {
+            // Data (or end of file, or an error the read will report) is
+            // there; the read can go ahead once it has a buffer.
+            //
+            startRead(w);
+        }
+        else if(cqe.res == -EAGAIN || cqe.res == -EINTR)
+        {
+            // Nothing was transferred; try again.
+            //
+            uringSubmit(w, op);
+            continue;
+        }
+        else if(cqe.res == -ENOBUFS)
+        {
+            // Every buffer is promised before a read is submitted, so this
+            // should not happen; if it does, the read waits in line for
+            // the next buffer handed back instead of being retried.
+            //
+            bufsFree++;
+            waitForBuffer(w);
+            continue;
+        }
+        else
+        {
+            w->armed[op] = 0;
+            handler(w, op, cqe.res, data);
+        }
+
+        // A finished read gives back the buffer it was promised, whether
+        // it used it or not.
+        //
+        if(data != NULL)
+        {
+            provideBuffers(bid, 1);
+        }
+        if(op == IO_READ && !w->accept)
+        {
+            bufferBack();
+        }
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static void epollUpdate(struct IoWatch *w)
+//
+// Purpose: Registers the events a watch's armed operations need, if they
+//          changed. With nothing armed the registration is edge-triggered,
+//          so a hung-up descriptor nobody is reading (a paused pipe) does
+//          not report EPOLLHUP over and over.
+//
+// *****************************************************************************
+//
+static void epollUpdate(struct IoWatch *w)
+{
+    struct epoll_event ev;
+
+    ev.events = (w->armed[IO_READ] ? EPOLLIN : 0) |
+                (w->armed[IO_WRITE] ? EPOLLOUT : 0);
+    if(ev.events == 0)
+    {
+        ev.events = EPOLLET;
+    }
+    if(w->fd < 0 || ev.events == w->events)
+    {
+        return;
+    }
+
+    ev.data.ptr = w;
+    if(epoll_ctl(epollFd, EPOLL_CTL_MOD, w->fd, &ev) == -1)
+    {
+        perror("epoll_ctl()");
+    }
+    w->events = ev.events;
+}
+
+
+// *****************************************************************************
+//
+// static int epollWait(io_handler handler)
+//
+// Purpose: epoll side of ioWait(): waits for readiness, does the armed reads
+//          and writes, and reports them as completions.
+//
+// *****************************************************************************
+//
+static int epollWait(io_handler handler)
+{
+    struct epoll_event events[MAX_EVENTS];  // Ready descriptors
+    struct IoWatch *w;
+    ssize_t res;
+    ssize_t done;
+    int n;
+    int i;
+
+    n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+    if(n < 0)
+    {
+        if(errno == EINTR)
+        {
+            return 0;
+        }
+        perror("epoll_wait()");
+        return -1;
+    }
+
+    for(i = 0; i < n; i++)
+    {
+        w = (struct IoWatch *) events[i].data.ptr;
+
+        // The read half. A descriptor closed while handling an earlier
+        // event in this batch has nothing left to do.
+        //
+        if(w->fd >= 0 && w->armed[IO_READ] &&
+           (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        {
+            if(w->accept)
+            {
+                res = accept4(w->fd, NULL, NULL, SOCK_CLOEXEC);
+            }
+            else
+            {
+                res = read(w->fd, epollBuf, sizeof(epollBuf));
+            }
+
+            if(res < 0)
+            {
+                res = -errno;
+            }
+            if(res != -EAGAIN && res != -EINTR)
+            {
+                w->armed[IO_READ] = 0;
+                handler(w, IO_READ, res, epollBuf);
+            }
+        }
+
+        // The write half: write as much as the descriptor takes.
+        //
+        if(w->fd >= 0 && w->armed[IO_WRITE] &&
+           (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+        {
+            done = 0;
+            while((size_t)done < w->wlen)
+            {
+                res = write(w->fd, w->wdata + done, w->wlen - done);
+                if(res < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(res < 0)
+                {
+                    break;
+                }
+                done += res;
+            }
+
+            if(done > 0 || errno != EAGAIN)
+            {
+                w->armed[IO_WRITE] = 0;
+                handler(w, IO_WRITE, done > 0 ? done : -errno, NULL);
+            }
+        }
+
+        epollUpdate(w);
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// const char *ioInit(void)
+//
+// Purpose: Picks and sets up the backend.
+//
+// *****************************************************************************
+//
+const char *ioInit(void)
+{
+    const char *want = getenv(IO_ENV);
+
+    if((want == NULL || strcmp(want, "epoll") != 0) && uringInit() == 0)
+    {
+        useUring = 1;
+        return "io_uring";
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollFd < 0)
+    {
+        perror("epoll_create1()");
+        return NULL;
+    }
+    return "epoll";
+}
+
+
+// *****************************************************************************
+//
+// void ioAdd(struct IoWatch *w, int fd, int accept)
+//
+// Purpose: Starts managing a descriptor. epoll needs it non-blocking; with
+//          io_uring it must block, or the kernel hands EAGAIN back instead
+//          of waiting for data itself.
+//
+// *****************************************************************************
+//
+void ioAdd(struct IoWatch *w, int fd, int accept)
+{
+    struct epoll_event ev;
+    int flags = fcntl(fd, F_GETFL);
+
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->accept = accept;
+
+    if(useUring)
+    {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    ev.events = w->events = EPOLLET;
+    ev.data.ptr = w;
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        perror("epoll_ctl()");
+    }
+}
+
+
+// *****************************************************************************
+//
+// void ioRead(struct IoWatch *w)
+//
+// Purpose: Arms a read. With io_uring a read into the pool first waits for
+//          data with a poll, so a descriptor that stays quiet holds no
+//          buffer and no place in line for one; an accept is submitted as
+//          it is.
+//
+// *****************************************************************************
+//
+void ioRead(struct IoWatch *w)
+{
+    if(w->fd < 0 || w->armed[IO_READ])
+    {
+        return;
+    }
+
+    w->armed[IO_READ] = 1;
+    if(useUring)
+    {
+        uringSubmit(w, w->accept ? IO_READ : OP_POLL);
+    }
+    else
+    {
+        epollUpdate(w);
+    }
+}
+
+
+// *****************************************************************************
+//
+// void ioWrite(struct IoWatch *w, const char *data, size_t len)
+//
+// Purpose: Arms a write.
+//
+// *****************************************************************************
+//
+void ioWrite(struct IoWatch *w, const char *data, size_t len)
+{
+    if(w->fd < 0 || w->armed[IO_WRITE])
+    {
+        return;
+    }
+
+    w->armed[IO_WRITE] = 1;
+    w->wdata = data;
+    w->wlen = len;
+    if(useUring)
+    {
+        uringSubmit(w, IO_WRITE);
+    }
+    else
+    {
+        epollUpdate(w);
+    }
+}
+
+
+// *****************************************************************************
+//
+// void ioClose(struct IoWatch *w)
+//
+// Purpose: Closes a watch, cancelling what the kernel still holds for it
+//          and taking it out of the line for a buffer. With io_uring the
+//          close itself is queued behind the cancels, so the descriptor
+//          number cannot be reused before operations already queued for it
+//          have been submitted.
+//
+// *****************************************************************************
+//
+void ioClose(struct IoWatch *w)
+{
+    struct io_uring_sqe *sqe;
+    struct IoWatch *prev;
+    struct IoWatch *p;
+    int op;
+
+    if(w->fd < 0)
+    {
+        return;
+    }
+
+    if(useUring)
+    {
+        if(w->waiting)
+        {
+            for(prev = NULL, p = waitHead; p != w; prev = p, p = p->next)
+            {
+            }
+            if(prev != NULL)
+            {
+                prev->next = w->next;
+            }
+            else
+            {
+                waitHead = w->next;
+            }
+            if(waitTail == w)
+            {
+                waitTail = prev;
+            }
+            w->waiting = 0;
+            w->armed[IO_READ] = 0;
+        }
+
+        // An armed read is either at its poll or at the read itself;
+        // cancelling both is simpler than tracking which, and the cancel
+        // that finds nothing is harmless.
+        //
+        for(op = IO_READ; op <= OP_POLL; op++)
+        {
+            if(w->armed[op == IO_WRITE ? IO_WRITE : IO_READ])
+            {
+                sqe = getSqe();
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = (uintptr_t)w | (unsigned int)op;
+                sqe->user_data = 0;
+            }
+        }
+        sqe = getSqe();
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = w->fd;
+        sqe->user_data = 0;
+    }
+    else
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, w->fd, NULL);
+        close(w->fd);
+    }
+
+    w->fd = -1;
+    w->armed[IO_READ] = w->armed[IO_WRITE] = 0;
+}
+
+
+// *****************************************************************************
+//
+// int ioBusy(struct IoWatch *w)
+//
+// Purpose: Tells whether the kernel still holds operations for a watch.
+//
+// *****************************************************************************
+//
+int ioBusy(struct IoWatch *w)
+{
+    return w->inflight > 0;
+}
+
+
+// *****************************************************************************
+//
+// int ioWait(io_handler handler)
+//
+// Purpose: Runs one round of the backend's event loop.
+//
+// *****************************************************************************
+//
+int ioWait(io_handler handler)
+{
+    return useUring ? uringWait(handler) : epollWait(handler);
+}
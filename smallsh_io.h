@@ -0,0 +1,221 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_io.h
+//
+//
+// Overview:
+//    Completion-style I/O for the shell's own byte moving (server mode's
+//    sockets and program pipes).
+//
+//    The caller asks for a read or a write on a descriptor and later gets a
+//    callback with the result, much like read() or write() returning. Two
+//    backends sit behind the same calls:
+//
+//       io_uring  Reads, writes and accepts are queued in a ring shared
+//                 with the kernel and handed over in batches, so one
+//                 system call per wakeup submits every new request and
+//                 collects every finished one. Reads draw from a pool of
+//                 buffers registered with the kernel once (a provided
+//                 buffer group). A read first polls for data, then takes
+//                 its place in line for a buffer, so any number of quiet
+//                 descriptors can be watched and no more reads are ever
+//                 submitted than there are buffers for.
+//
+//       epoll     Used when io_uring is unavailable (old kernel, seccomp,
+//                 io_uring_disabled) or SMALLSH_IO=epoll is set. Waits for
+//                 readiness and does the read or write itself, then makes
+//                 the same callback.
+//
+// *****************************************************************************
+//
+
+
+#ifndef SMALLSH_IO_H
+#define SMALLSH_IO_H
+
+
+#include <sys/types.h>
+
+
+#define IO_READ      0                  // Read (or accept) operation
+#define IO_WRITE     1                  // Write operation
+#define IO_BUF_SIZE  65536              // Most bytes one read returns
+#define IO_ENV       "SMALLSH_IO"       // Set to "epoll" to skip io_uring
+
+
+// struct IoWatch: A descriptor and the operations armed on it. Embed it in
+//                 a larger structure to find the owner in the callback.
+//
+// fd       -> Descriptor, or -1 once ioClose() has been called
+//
+// accept   -> Reads on this descriptor accept connections instead
+//
+// armed    -> Whether a read / write is requested and not yet completed
+//
+// inflight -> Operations the kernel still holds (io_uring only); the watch
+//             must not be freed until ioBusy() says so
+//
+// events   -> epoll events currently registered (epoll only)
+//
+// waiting  -> The armed read has data and is in line for a pool buffer;
+// next        next is the watch after it in line (io_uring only)
+//
+// wdata    -> Bytes of the armed write, and their length
+// wlen
+//
+struct IoWatch {
+    int fd;
+    int accept;
+    char armed[2];
+    int inflight;
+    unsigned int events;
+    int waiting;
+    struct IoWatch *next;
+    const char *wdata;
+    size_t wlen;
+};
+
+// Called once per completed operation:
+//
+//    op   -> IO_READ or IO_WRITE
+//    res  -> Bytes read or written, the new descriptor for an accept, 0 at
+//            end of file, or a negative errno value
+//    data -> For reads, the bytes read; only valid during the call
+//
+// The operation is no longer armed when the callback runs; arm it again to
+// keep reading or writing.
+//
+typedef void (*io_handler)(struct IoWatch *w, int op, ssize_t res, char *data);
+
+
+// *****************************************************************************
+//
+// const char *ioInit(void)
+//
+//    Entry:   None.
+//
+//    Exit:    Returns the name of the backend in use ("io_uring" or "epoll"),
+//             or NULL (with a message printed) if neither could be set up.
+//
+//    Purpose: Set up the I/O backend, preferring io_uring.
+//
+// *****************************************************************************
+//
+const char *ioInit(void);
+
+
+// *****************************************************************************
+//
+// void ioAdd(struct IoWatch *w, int fd, int accept)
+//
+//    Entry:   struct IoWatch *w
+//                Watch to set up; nothing may be armed on it yet.
+//             int fd
+//                Descriptor to watch. Its O_NONBLOCK flag is set as the
+//                backend needs it.
+//             int accept
+//                Non-zero if fd is a listening socket.
+//
+//    Exit:    None.
+//
+//    Purpose: Start managing a descriptor.
+//
+// *****************************************************************************
+//
+void ioAdd(struct IoWatch *w, int fd, int accept);
+
+
+// *****************************************************************************
+//
+// void ioRead(struct IoWatch *w)
+//
+//    Entry:   struct IoWatch *w
+//                Watch to read from (or accept on).
+//
+//    Exit:    None.
+//
+//    Purpose: Arm a read of up to IO_BUF_SIZE bytes.
+//
+// *****************************************************************************
+//
+void ioRead(struct IoWatch *w);
+
+
+// *****************************************************************************
+//
+// void ioWrite(struct IoWatch *w, const char *data, size_t len)
+//
+//    Entry:   struct IoWatch *w
+//                Watch to write to.
+//             const char *data
+//                Bytes to write; must stay untouched until the completion.
+//             size_t len
+//                Number of bytes (the write may complete partially).
+//
+//    Exit:    None.
+//
+//    Purpose: Arm a write.
+//
+// *****************************************************************************
+//
+void ioWrite(struct IoWatch *w, const char *data, size_t len);
+
+
+// *****************************************************************************
+//
+// void ioClose(struct IoWatch *w)
+//
+//    Entry:   struct IoWatch *w
+//                Watch to close. Does nothing if it is already closed.
+//
+//    Exit:    None.
+//
+//    Purpose: Close the descriptor and cancel whatever is armed on it; no
+//             more callbacks are made for the watch.
+//
+// *****************************************************************************
+//
+void ioClose(struct IoWatch *w);
+
+
+// *****************************************************************************
+//
+// int ioBusy(struct IoWatch *w)
+//
+//    Entry:   struct IoWatch *w
+//                A closed watch.
+//
+//    Exit:    Returns non-zero while the kernel may still use the watch or
+//             its write data.
+//
+//    Purpose: Tell when a closed watch's memory can be freed (checked after
+//             ioWait() returns).
+//
+// *****************************************************************************
+//
+int ioBusy(struct IoWatch *w);
+
+
+// *****************************************************************************
+//
+// int ioWait(io_handler handler)
+//
+//    Entry:   io_handler handler
+//                Function called for each completed operation.
+//
+//    Exit:    Returns 0, or -1 (with a message printed) on a fatal error.
+//
+//    Purpose: Submit everything armed since the last call, wait for at
+//             least one operation to complete, and call handler for every
+//             completion available.
+//
+// *****************************************************************************
+//
+int ioWait(io_handler handler);
+
+
+#endif
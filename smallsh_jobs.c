@@ -0,0 +1,912 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_jobs.c
+//
+//
+// Overview:
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language.
+//
+//    This file contains the job registry: reaping background processes into
+//    the ring of finished jobs, collecting their progress reports from the
+//    shared-memory status ring, the 'jobs' built-in, and the optional stats
+//    socket that lets another program ask what the shell is running.
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // accept4(), memfd_create()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "smallsh.h"
+
+
+static pthread_mutex_t jobsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct Shell *statsShell;        // Shell the stats thread reports on
+static int statsFd = -1;                // Listening stats socket
+static struct StatusRing *statusRing;   // Shared-memory status ring
+static unsigned int statusHead;         // Next status ring ticket to read
+
+
+// *****************************************************************************
+//
+// void lockJobs(void)
+// void unlockJobs(void)
+//
+// Purpose: Guard the job registry against the stats socket thread.
+//
+// *****************************************************************************
+//
+void lockJobs(void)
+{
+    pthread_mutex_lock(&jobsMutex);
+}
+
+void unlockJobs(void)
+{
+    pthread_mutex_unlock(&jobsMutex);
+}
+
+
+// *****************************************************************************
+//
+// void reapJobs(struct Shell *sh)
+//
+// Purpose: Reaps finished background processes (without waiting) and moves
+//          their nodes into the finished ring.
+//
+// *****************************************************************************
+//
+void reapJobs(struct Shell *sh)
+{
+    int wpid;                 // PID returned by waitpid()
+    int status;               // Exit status data from waitpid()
+    struct Node *prev;        // Previous node in the linked list
+    struct Node *curr;        // Current node in the linked list
+    struct JobRecord *rec;    // Ring slot for a finished process
+
+    prev = NULL;              // Start off at the beginning (no previous node)
+    curr = sh->head;          // Start at the head node
+
+    while(curr != NULL)
+    {
+        // Try to reap the zombie from the process. Do not wait for a zombie
+        // to be reaped; try it and move along (WNOHANG).
+        //
+        wpid = (int)waitpid(curr->pid, &status, WNOHANG);
+        if(wpid <= 0)
+        {
+            prev = curr;
+            curr = curr->next;
+            continue;
+        }
+
+        // Record the finished process in the ring, overwriting the oldest
+        // record once the ring is full.
+        //
+        rec = &sh->done.rec[sh->done.count % JOB_RING_SIZE];
+        rec->pid = curr->pid;
+        rec->start = curr->start;
+        clock_gettime(CLOCK_REALTIME, &rec->end);
+        rec->status = status;
+        rec->notified = 0;
+        rec->argc = curr->argc;
+        memcpy(rec->argv, curr->argv, sizeof(rec->argv));
+        memcpy(rec->progress, curr->progress, sizeof(rec->progress));
+        memcpy(rec->result, curr->result, sizeof(rec->result));
+        sh->done.count++;
+
+        // Unlink and free the node. The PID will not be checked again.
+        //
+        if(prev == NULL)
+        {
+            sh->head = curr->next;
+            free(curr);
+            curr = sh->head;
+        }
+        else
+        {
+            prev->next = curr->next;
+            free(curr);
+            curr = prev->next;
+        }
+
+        // One less PID to process. Keep count.
+        //
+        sh->numNodes--;
+    }
+}
+
+
+// *****************************************************************************
+//
+// int createStatusRing(struct Shell *sh)
+//
+// Purpose: Sets up the status ring in an inheritable memfd, the first time
+//          it is called, and exports its descriptor number.
+//
+// *****************************************************************************
+//
+int createStatusRing(struct Shell *sh)
+{
+    static int tried;         // Set up already (or failed to)
+    struct StatusRing *ring;  // Ring being set up
+    char fdStr[16];           // Descriptor number for the environment
+    unsigned int i;
+    int fd;
+
+    if(tried)
+    {
+        return statusRing != NULL ? 0 : -1;
+    }
+    tried = 1;
+
+    // No MFD_CLOEXEC: every program the shell starts should inherit it.
+    //
+    fd = memfd_create("smallsh-status", 0);
+    if(fd < 0)
+    {
+        perror("Status ring memfd_create()");
+        return -1;
+    }
+    if(ftruncate(fd, sizeof(struct StatusRing)) == -1)
+    {
+        perror("Status ring ftruncate()");
+        close(fd);
+        return -1;
+    }
+
+    ring = (struct StatusRing *) mmap(NULL, sizeof(struct StatusRing),
+                                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(ring == MAP_FAILED)
+    {
+        perror("Status ring mmap()");
+        close(fd);
+        return -1;
+    }
+
+    // The memfd starts out zeroed; each slot's sequence number starts at
+    // its own index, with no owner (free for the first lap).
+    //
+    for(i = 0; i < STATUS_RING_SLOTS; i++)
+    {
+        atomic_store_explicit(&ring->slot[i].state, STATUS_STATE(i, 0),
+                              memory_order_relaxed);
+    }
+    ring->slots = STATUS_RING_SLOTS;
+    ring->magic = STATUS_RING_MAGIC;
+
+    // Only now let the stats thread see it.
+    //
+    lockJobs();
+    statusRing = ring;
+    unlockJobs();
+
+    snprintf(fdStr, sizeof(fdStr), "%d", fd);
+    setVar(sh, STATUS_RING_ENV, strlen(STATUS_RING_ENV), fdStr);
+    tracePoint("status ring created");
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static long long nowMs(void)
+//
+// Purpose: Returns CLOCK_MONOTONIC time in milliseconds.
+//
+// *****************************************************************************
+//
+static long long nowMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+// *****************************************************************************
+//
+// void drainStatus(struct Shell *sh)
+//
+// Purpose: Consumes the status ring, filing each message with its job.
+//
+// *****************************************************************************
+//
+void drainStatus(struct Shell *sh)
+{
+    struct StatusSlot *slot;  // Slot being read
+    struct Node *curr;        // Running job being checked
+    char *dst;                // Where the message goes
+    unsigned int head;        // Ticket being read
+    unsigned int i;           // Ring position of a finished job
+    unsigned int oldest;      // Oldest finished-ring position still held
+    unsigned long long state; // State of the slot being read
+    int owner;                // Process that claimed the slot
+
+    if(statusRing == NULL)
+    {
+        return;
+    }
+
+    head = statusHead;
+    for(;;)
+    {
+        // The record for ticket head is ready once its sequence number has
+        // moved to head + 1. Anything else means no more records (or a
+        // poster is still filling this one in).
+        //
+        slot = &statusRing->slot[head % STATUS_RING_SLOTS];
+        state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        if(STATUS_SEQ(state) != head + 1)
+        {
+            // A poster that claimed the slot and died before publishing
+            // would hold up every record behind it, so take the slot back
+            // once its owner is gone. A poster that is merely slow (or
+            // stopped) still owns it and gets waited for.
+            //
+            owner = STATUS_OWNER(state);
+            if(STATUS_SEQ(state) != head || owner == 0 ||
+               kill(owner, 0) == 0 || errno != ESRCH)
+            {
+                break;
+            }
+            if(atomic_compare_exchange_strong_explicit(&slot->state, &state,
+                                                       STATUS_STATE(head + STATUS_RING_SLOTS, 0),
+                                                       memory_order_acq_rel,
+                                                       memory_order_acquire))
+            {
+                head++;
+            }
+            continue;
+        }
+
+        // Find the job the record is about: running jobs first, then the
+        // finished ring, newest first.
+        //
+        dst = NULL;
+        for(curr = sh->head; curr != NULL && dst == NULL; curr = curr->next)
+        {
+            if(curr->pid == slot->pid)
+            {
+                dst = slot->kind == STATUS_RESULT ? curr->result : curr->progress;
+            }
+        }
+        oldest = sh->done.count > JOB_RING_SIZE ? sh->done.count - JOB_RING_SIZE : 0;
+        for(i = sh->done.count; i != oldest && dst == NULL; i--)
+        {
+            if(sh->done.rec[(i - 1) % JOB_RING_SIZE].pid == slot->pid)
+            {
+                dst = slot->kind == STATUS_RESULT ? sh->done.rec[(i - 1) % JOB_RING_SIZE].result
+                                                  : sh->done.rec[(i - 1) % JOB_RING_SIZE].progress;
+            }
+        }
+
+        // The slot is shared with other processes, so never trust its
+        // message to be terminated.
+        //
+        if(dst != NULL)
+        {
+            memcpy(dst, slot->msg, STATUS_MSG_MAX);
+            dst[STATUS_MSG_MAX - 1] = '\0';
+        }
+
+        // Hand the slot back to posters for the next lap.
+        //
+        atomic_store_explicit(&slot->state, STATUS_STATE(head + STATUS_RING_SLOTS, 0),
+                              memory_order_release);
+        head++;
+    }
+    statusHead = head;
+}
+
+
+// *****************************************************************************
+//
+// static void jsonString(FILE *out, const char *str)
+//
+// Purpose: Writes a string as a quoted, escaped JSON string.
+//
+// *****************************************************************************
+//
+static void jsonString(FILE *out, const char *str)
+{
+    const unsigned char *p;
+
+    fputc('"', out);
+    for(p = (const unsigned char *)str; *p != '\0'; p++)
+    {
+        if(*p == '"' || *p == '\\')
+        {
+            fprintf(out, "\\%c", *p);
+        }
+        else if(*p < 0x20)
+        {
+            fprintf(out, "\\u%04x", *p);
+        }
+        else
+        {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+
+// *****************************************************************************
+//
+// static void jsonJob(FILE *out, pid_t pid, int argc, const char *argv,
+//                     const char *progress, const char *result,
+//                     const struct timespec *start, const struct JobRecord *rec)
+//
+// Purpose: Writes one job as a JSON object. rec is NULL for a job that is
+//          still running.
+//
+// *****************************************************************************
+//
+static void jsonJob(FILE *out, pid_t pid, int argc, const char *argv,
+                    const char *progress, const char *result,
+                    const struct timespec *start, const struct JobRecord *rec)
+{
+    int i;
+
+    fprintf(out, "{\"pid\":%d,\"argv\":[", (int)pid);
+    for(i = 0; i < argc; i++)
+    {
+        if(i > 0)
+        {
+            fputc(',', out);
+        }
+        jsonString(out, argv);
+        argv += strlen(argv) + 1;
+    }
+    fprintf(out, "],\"start\":%ld.%03ld", (long)start->tv_sec, start->tv_nsec / 1000000);
+
+    if(rec == NULL)
+    {
+        fprintf(out, ",\"state\":\"running\",\"exit_status\":null,\"signal\":null,\"end\":null");
+    }
+    else if(WIFSIGNALED(rec->status))
+    {
+        fprintf(out, ",\"state\":\"signaled\",\"exit_status\":null,\"signal\":%d",
+                WTERMSIG(rec->status));
+    }
+    else
+    {
+        fprintf(out, ",\"state\":\"exited\",\"exit_status\":%d,\"signal\":null",
+                WEXITSTATUS(rec->status));
+    }
+    if(rec != NULL)
+    {
+        fprintf(out, ",\"end\":%ld.%03ld", (long)rec->end.tv_sec, rec->end.tv_nsec / 1000000);
+    }
+
+    // Messages posted to the status ring, if any.
+    //
+    fprintf(out, ",\"progress\":");
+    if(progress[0] != '\0')
+    {
+        jsonString(out, progress);
+    }
+    else
+    {
+        fprintf(out, "null");
+    }
+    fprintf(out, ",\"result\":");
+    if(result[0] != '\0')
+    {
+        jsonString(out, result);
+    }
+    else
+    {
+        fprintf(out, "null");
+    }
+
+    fputc('}', out);
+}
+
+
+// *****************************************************************************
+//
+// void writeJobsJson(struct Shell *sh, FILE *out)
+//
+// Purpose: Writes {"shell_pid":N,"running":[...],"finished":[...]}, with
+//          finished jobs oldest first.
+//
+// *****************************************************************************
+//
+void writeJobsJson(struct Shell *sh, FILE *out)
+{
+    struct Node *curr;        // Running job being written
+    struct JobRecord *rec;    // Finished job being written
+    unsigned int i;           // Ring position
+    unsigned int oldest;      // Oldest ring position still held
+
+    fprintf(out, "{\"shell_pid\":%d,\"running\":[", (int)getpid());
+    for(curr = sh->head; curr != NULL; curr = curr->next)
+    {
+        jsonJob(out, curr->pid, curr->argc, curr->argv, curr->progress,
+                curr->result, &curr->start, NULL);
+        if(curr->next != NULL)
+        {
+            fputc(',', out);
+        }
+    }
+
+    fprintf(out, "],\"finished\":[");
+    oldest = sh->done.count > JOB_RING_SIZE ? sh->done.count - JOB_RING_SIZE : 0;
+    for(i = oldest; i != sh->done.count; i++)
+    {
+        rec = &sh->done.rec[i % JOB_RING_SIZE];
+        if(i != oldest)
+        {
+            fputc(',', out);
+        }
+        jsonJob(out, rec->pid, rec->argc, rec->argv, rec->progress,
+                rec->result, &rec->start, rec);
+    }
+    fprintf(out, "]}\n");
+}
+
+
+// *****************************************************************************
+//
+// static void printJob(int argc, const char *argv, const char *progress,
+//                      const char *result)
+//
+// Purpose: Prints a packed argument list separated by spaces, followed by
+//          the job's latest progress or result message in brackets.
+//
+// *****************************************************************************
+//
+static void printJob(int argc, const char *argv, const char *progress,
+                     const char *result)
+{
+    int i;
+
+    for(i = 0; i < argc; i++)
+    {
+        printf(i > 0 ? " %s" : "%s", argv);
+        argv += strlen(argv) + 1;
+    }
+    if(result[0] != '\0')
+    {
+        printf("  [%s]", result);
+    }
+    else if(progress[0] != '\0')
+    {
+        printf("  [%s]", progress);
+    }
+    printf("\n");
+}
+
+
+// *****************************************************************************
+//
+// int myJobs(struct Shell *sh, char *userArgs[], int numArgs)
+//
+// Purpose: Built-in jobs command.
+//
+// *****************************************************************************
+//
+int myJobs(struct Shell *sh, char *userArgs[], int numArgs)
+{
+    struct Node *curr;        // Running job being listed
+    struct JobRecord *rec;    // Finished job being listed
+    unsigned int i;           // Ring position
+    unsigned int oldest;      // Oldest ring position still held
+
+    if(numArgs > 2 || (numArgs == 2 && strcmp(userArgs[1], "--json") != 0))
+    {
+        printf("Invalid: usage is jobs [--json].\n");
+        return 1;
+    }
+
+    // Report anything that finished since the last prompt first, so the
+    // listing is current.
+    //
+    clearChildren(sh);
+
+    lockJobs();
+    if(numArgs == 2)
+    {
+        writeJobsJson(sh, stdout);
+    }
+    else
+    {
+        for(curr = sh->head; curr != NULL; curr = curr->next)
+        {
+            printf("%d  running  ", (int)curr->pid);
+            printJob(curr->argc, curr->argv, curr->progress, curr->result);
+        }
+
+        oldest = sh->done.count > JOB_RING_SIZE ? sh->done.count - JOB_RING_SIZE : 0;
+        for(i = oldest; i != sh->done.count; i++)
+        {
+            rec = &sh->done.rec[i % JOB_RING_SIZE];
+            if(WIFSIGNALED(rec->status))
+            {
+                printf("%d  terminated by signal %d  ", (int)rec->pid, WTERMSIG(rec->status));
+            }
+            else
+            {
+                printf("%d  exit value %d  ", (int)rec->pid, WEXITSTATUS(rec->status));
+            }
+            printJob(rec->argc, rec->argv, rec->progress, rec->result);
+        }
+    }
+    unlockJobs();
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// struct StatsClient: One connected stats client.
+//
+// fd       -> Client socket (non-blocking), or -1 for a free slot
+// query    -> Query line received so far, and its length
+// queryLen
+// reply    -> JSON reply once the query is answered (NULL until then), its
+// replyLen    length, and how much of it has been sent
+// sent
+// deadline -> CLOCK_MONOTONIC milliseconds by which the current step (the
+//             query, then the reply) must be done
+//
+// *****************************************************************************
+//
+struct StatsClient {
+    int fd;
+    char query[64];
+    size_t queryLen;
+    char *reply;
+    size_t replyLen;
+    size_t sent;
+    long long deadline;
+};
+
+
+// *****************************************************************************
+//
+// static void dropStats(struct StatsClient *c)
+//
+// Purpose: Closes a stats client and frees its slot.
+//
+// *****************************************************************************
+//
+static void dropStats(struct StatsClient *c)
+{
+    close(c->fd);
+    free(c->reply);
+    c->fd = -1;
+    c->reply = NULL;
+}
+
+
+// *****************************************************************************
+//
+// static int answerStats(struct StatsClient *c)
+//
+// Purpose: Builds the reply to a stats client's query. Returns -1 if it
+//          could not be built.
+//
+// *****************************************************************************
+//
+static int answerStats(struct StatsClient *c)
+{
+    FILE *out;                          // Stream writing into the reply
+
+    c->query[c->queryLen] = '\0';
+    c->query[strcspn(c->query, "\r\n")] = '\0';
+
+    out = open_memstream(&c->reply, &c->replyLen);
+    if(out == NULL)
+    {
+        return -1;
+    }
+
+    if(c->query[0] == '\0' || strcmp(c->query, "jobs") == 0)
+    {
+        // Reap first so finished jobs show up as finished even while the
+        // main loop is blocked at the prompt.
+        //
+        lockJobs();
+        drainStatus(statsShell);
+        reapJobs(statsShell);
+        writeJobsJson(statsShell, out);
+        unlockJobs();
+    }
+    else
+    {
+        fprintf(out, "{\"error\":\"unknown query\"}\n");
+    }
+    fclose(out);
+
+    c->sent = 0;
+    c->deadline = nowMs() + STATS_TIMEOUT_MS;
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static int serveStats(struct StatsClient *c, long long now)
+//
+// Purpose: Moves a stats client along as far as it will go without
+//          blocking: reads an optional query line, then writes a single
+//          JSON line back. Returns 1 while the client needs more time, or 0
+//          once it is finished (or failed) and should be dropped.
+//
+// *****************************************************************************
+//
+static int serveStats(struct StatsClient *c, long long now)
+{
+    ssize_t n;                          // Bytes from the latest recv()/send()
+
+    // Read up to a newline, end of file, or the deadline. A client that
+    // sends nothing gets the default query.
+    //
+    while(c->reply == NULL)
+    {
+        if(c->queryLen == sizeof(c->query) - 1 ||
+           memchr(c->query, '\n', c->queryLen) != NULL)
+        {
+            break;
+        }
+        n = recv(c->fd, c->query + c->queryLen, sizeof(c->query) - 1 - c->queryLen, 0);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && now < c->deadline)
+        {
+            return 1;
+        }
+        if(n <= 0)
+        {
+            break;
+        }
+        c->queryLen += n;
+    }
+    if(c->reply == NULL && answerStats(c) == -1)
+    {
+        return 0;
+    }
+
+    // MSG_NOSIGNAL: a client that hung up must not kill the shell with
+    // SIGPIPE. A client that stops reading is dropped at the deadline.
+    //
+    while(c->sent < c->replyLen)
+    {
+        n = send(c->fd, c->reply + c->sent, c->replyLen - c->sent, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && now < c->deadline)
+        {
+            return 1;
+        }
+        if(n <= 0)
+        {
+            return 0;
+        }
+        c->sent += n;
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static void *statsThread(void *arg)
+//
+// Purpose: Serves stats clients, forever. Up to STATS_MAX_CLIENTS are served
+//          side by side, each with its own deadline, so a client that never
+//          sends or never reads holds up nobody but itself.
+//
+// *****************************************************************************
+//
+static void *statsThread(void *arg)
+{
+    struct StatsClient clients[STATS_MAX_CLIENTS];
+    struct pollfd pfds[STATS_MAX_CLIENTS + 1];
+    int slot[STATS_MAX_CLIENTS + 1];   // Client each pfds entry belongs to
+    int numPfds;                        // Entries in use in pfds
+    int numClients = 0;                 // Connected clients
+    long long now;
+    long long wake;                     // Earliest client deadline
+    int fd;
+    int i;
+
+    (void)arg;
+
+    for(i = 0; i < STATS_MAX_CLIENTS; i++)
+    {
+        clients[i].fd = -1;
+        clients[i].reply = NULL;
+    }
+
+    for(;;)
+    {
+        // Watch the listener while there is room for another client, and
+        // each client for the direction it is waiting on.
+        //
+        numPfds = 0;
+        now = nowMs();
+        wake = -1;
+        if(numClients < STATS_MAX_CLIENTS)
+        {
+            pfds[numPfds].fd = statsFd;
+            pfds[numPfds].events = POLLIN;
+            slot[numPfds++] = -1;
+        }
+        for(i = 0; i < STATS_MAX_CLIENTS; i++)
+        {
+            if(clients[i].fd < 0)
+            {
+                continue;
+            }
+            pfds[numPfds].fd = clients[i].fd;
+            pfds[numPfds].events = clients[i].reply == NULL ? POLLIN : POLLOUT;
+            slot[numPfds++] = i;
+            if(wake < 0 || clients[i].deadline < wake)
+            {
+                wake = clients[i].deadline;
+            }
+        }
+
+        if(poll(pfds, numPfds, wake < 0 ? -1 : (int)(wake > now ? wake - now : 0)) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            perror("Stats socket poll()");
+            return NULL;
+        }
+
+        // Move along every client that is ready or out of time.
+        //
+        now = nowMs();
+        for(i = 0; i < numPfds; i++)
+        {
+            if(slot[i] < 0 ||
+               (pfds[i].revents == 0 && now < clients[slot[i]].deadline))
+            {
+                continue;
+            }
+            if(serveStats(&clients[slot[i]], now) == 0)
+            {
+                dropStats(&clients[slot[i]]);
+                numClients--;
+            }
+        }
+
+        // SOCK_CLOEXEC so a program forked by the shell in the meantime
+        // does not hold the client's connection open.
+        //
+        if(numPfds > 0 && slot[0] < 0 && (pfds[0].revents & POLLIN))
+        {
+            fd = accept4(statsFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0)
+            {
+                if(errno == EINTR || errno == ECONNABORTED || errno == EAGAIN ||
+                   errno == EWOULDBLOCK)
+                {
+                    continue;
+                }
+                perror("Stats socket accept()");
+                return NULL;
+            }
+            i = 0;
+            while(clients[i].fd >= 0)
+            {
+                i++;
+            }
+            clients[i].fd = fd;
+            clients[i].queryLen = 0;
+            clients[i].deadline = now + STATS_TIMEOUT_MS;
+            numClients++;
+        }
+    }
+
+    return NULL;
+}
+
+
+// *****************************************************************************
+//
+// int startStatsServer(struct Shell *sh, const char *path)
+//
+// Purpose: Creates the stats socket and starts the thread that serves it.
+//
+// *****************************************************************************
+//
+int startStatsServer(struct Shell *sh, const char *path)
+{
+    struct sockaddr_un addr;  // Socket address
+    struct stat st;           // What is already at path, if anything
+    pthread_t thread;         // Stats thread
+    sigset_t all;             // Signals blocked in the stats thread
+    sigset_t saved;           // Signal mask to restore afterward
+    int err;
+
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "smallsh: %s: socket path too long\n", path);
+        return -1;
+    }
+
+    // A socket left behind by an earlier shell would make bind() fail.
+    // Only remove it if it really is a socket.
+    //
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        unlink(path);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    statsFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(statsFd < 0)
+    {
+        perror("Stats socket");
+        return -1;
+    }
+    if(bind(statsFd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+       listen(statsFd, 16) == -1)
+    {
+        perror(path);
+        close(statsFd);
+        statsFd = -1;
+        return -1;
+    }
+
+    statsShell = sh;
+
+    // Signals are for the main thread; start the stats thread with all of
+    // them blocked.
+    //
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    err = pthread_create(&thread, NULL, statsThread, NULL);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    if(err != 0)
+    {
+        fprintf(stderr, "smallsh: stats thread: %s\n", strerror(err));
+        close(statsFd);
+        statsFd = -1;
+        return -1;
+    }
+    pthread_detach(thread);
+
+    return 0;
+}
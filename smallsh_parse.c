@@ -0,0 +1,913 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_parse.c
+//
+//
+// Overview:
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language.
+//
+//    This file contains the tokenizer and the parser that turns a script
+//    into a syntax tree. The grammar, in rough terms:
+//
+//       list     : andor ((';' | '&' | newline) andor)*
+//       andor    : command (('&&' | '||') command)*
+//       command  : simple | if | while | until | for | '{' list '}'
+//                | name '(' ')' compound
+//       simple   : (word | '<' word | '>' word)+
+//
+//    Words are separated by blanks and operators. A word starting with #
+//    begins a comment that runs to the end of the line. There is no quoting.
+//
+// *****************************************************************************
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include "smallsh.h"
+
+
+// Token types
+//
+enum TokenType {
+    T_WORD,
+    T_SEMI,          // ;
+    T_NEWLINE,       // \n
+    T_AMP,           // &
+    T_AND,           // &&
+    T_OR,            // ||
+    T_LT,            // <
+    T_GT,            // >
+    T_LPAREN,        // (
+    T_RPAREN,        // )
+    T_EOF
+};
+
+// struct Token: The parser's one-token lookahead
+//
+// text, len -> The token's characters in the source (not NUL-terminated)
+//
+// start     -> Offset of the token in the source
+//
+struct Token {
+    int type;
+    const char *text;
+    size_t len;
+    size_t start;
+};
+
+// struct Parser: Tokenizer and parser state
+//
+struct Parser {
+    const char *src;            // Script text
+    size_t len;                 // Length of the script text
+    size_t pos;                 // Offset just past the lookahead token
+    size_t prevEnd;             // Offset just past the last consumed token
+    struct Token tok;           // Lookahead token
+    struct Arena *arena;        // Where nodes and words are allocated
+    int depth;                  // Nesting of compound commands
+    int err;                    // PARSE_OK, PARSE_ERROR or PARSE_INCOMPLETE
+    char *errMsg;               // Caller's error message buffer
+    size_t errLen;              // Size of the error message buffer
+};
+
+
+static struct AstNode *parseList(struct Parser *p);
+static struct AstNode *parseCommand(struct Parser *p);
+
+
+// *****************************************************************************
+//
+// static int isBreak(const char *s, size_t i, size_t len)
+//
+// Purpose: Tells whether the character at s[i] ends a word.
+//
+// *****************************************************************************
+//
+static int isBreak(const char *s, size_t i, size_t len)
+{
+    // (strchr() also matches the terminating NUL, so a NUL byte in the
+    // input ends a word.)
+    //
+    if(strchr(" \t\r\n;&<>()", s[i]) != NULL)
+    {
+        return 1;
+    }
+
+    // A lone | is part of a word; only || is an operator.
+    //
+    return s[i] == '|' && i + 1 < len && s[i + 1] == '|';
+}
+
+
+// *****************************************************************************
+//
+// static void nextToken(struct Parser *p)
+//
+// Purpose: Scans the next token from the source into p->tok.
+//
+// *****************************************************************************
+//
+static void nextToken(struct Parser *p)
+{
+    const char *s = p->src;
+    size_t i = p->pos;
+    size_t len = 1;
+
+    // Skip blanks and comments. A comment starts with a # at the beginning
+    // of a word and runs up to (not including) the end of the line. Stray
+    // NUL bytes count as blanks.
+    //
+    for(;;)
+    {
+        while(i < p->len && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' ||
+                             s[i] == '\0'))
+        {
+            i++;
+        }
+        if(i < p->len && s[i] == '#')
+        {
+            while(i < p->len && s[i] != '\n')
+            {
+                i++;
+            }
+            continue;
+        }
+        break;
+    }
+
+    p->tok.start = i;
+    p->tok.text = s + i;
+
+    if(i >= p->len)
+    {
+        p->tok.type = T_EOF;
+        len = 0;
+    }
+    else
+    {
+        switch(s[i])
+        {
+            case '\n': p->tok.type = T_NEWLINE; break;
+            case ';':  p->tok.type = T_SEMI;    break;
+            case '<':  p->tok.type = T_LT;      break;
+            case '>':  p->tok.type = T_GT;      break;
+            case '(':  p->tok.type = T_LPAREN;  break;
+            case ')':  p->tok.type = T_RPAREN;  break;
+            case '&':
+                if(i + 1 < p->len && s[i + 1] == '&')
+                {
+                    p->tok.type = T_AND;
+                    len = 2;
+                }
+                else
+                {
+                    p->tok.type = T_AMP;
+                }
+                break;
+            default:
+                if(s[i] == '|' && i + 1 < p->len && s[i + 1] == '|')
+                {
+                    p->tok.type = T_OR;
+                    len = 2;
+                    break;
+                }
+
+                // Anything else is a word running up to the next blank or
+                // operator.
+                //
+                p->tok.type = T_WORD;
+                while(i + len < p->len && !isBreak(s, i + len, p->len))
+                {
+                    len++;
+                }
+        }
+    }
+
+    p->tok.len = len;
+    p->pos = i + len;
+}
+
+
+// *****************************************************************************
+//
+// static void consume(struct Parser *p)
+//
+// Purpose: Moves past the lookahead token.
+//
+// *****************************************************************************
+//
+static void consume(struct Parser *p)
+{
+    p->prevEnd = p->tok.start + p->tok.len;
+    nextToken(p);
+}
+
+
+// *****************************************************************************
+//
+// static int isWord(struct Parser *p, const char *word)
+//
+// Purpose: Tells whether the lookahead token is the given word (used to spot
+//          reserved words such as "then" and "done").
+//
+// *****************************************************************************
+//
+static int isWord(struct Parser *p, const char *word)
+{
+    return p->tok.type == T_WORD && p->tok.len == strlen(word) &&
+           strncmp(p->tok.text, word, p->tok.len) == 0;
+}
+
+
+// *****************************************************************************
+//
+// static int atListEnd(struct Parser *p)
+//
+// Purpose: Tells whether the lookahead token ends a command list: end of
+//          input, a ')' or a reserved word that closes a compound command.
+//
+// *****************************************************************************
+//
+static int atListEnd(struct Parser *p)
+{
+    return p->tok.type == T_EOF || p->tok.type == T_RPAREN ||
+           isWord(p, "then") || isWord(p, "elif") || isWord(p, "else") ||
+           isWord(p, "fi") || isWord(p, "do") || isWord(p, "done") ||
+           isWord(p, "}");
+}
+
+
+// *****************************************************************************
+//
+// static void unexpected(struct Parser *p)
+//
+// Purpose: Flags the lookahead token as a syntax error. Running out of input
+//          is not an error but a request for more input (PARSE_INCOMPLETE).
+//
+// *****************************************************************************
+//
+static void unexpected(struct Parser *p)
+{
+    if(p->err != PARSE_OK)
+    {
+        return;
+    }
+
+    if(p->tok.type == T_EOF)
+    {
+        p->err = PARSE_INCOMPLETE;
+        snprintf(p->errMsg, p->errLen, "syntax error: unexpected end of file");
+    }
+    else if(p->tok.type == T_NEWLINE)
+    {
+        p->err = PARSE_ERROR;
+        snprintf(p->errMsg, p->errLen,
+                 "syntax error near unexpected token `newline'");
+    }
+    else
+    {
+        p->err = PARSE_ERROR;
+        snprintf(p->errMsg, p->errLen,
+                 "syntax error near unexpected token `%.*s'",
+                 (int)p->tok.len, p->tok.text);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void failParse(struct Parser *p, const char *msg)
+//
+// Purpose: Flags a syntax error with a specific message.
+//
+// *****************************************************************************
+//
+static void failParse(struct Parser *p, const char *msg)
+{
+    if(p->err == PARSE_OK)
+    {
+        p->err = PARSE_ERROR;
+        snprintf(p->errMsg, p->errLen, "syntax error: %s", msg);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void expectWord(struct Parser *p, const char *word)
+//
+// Purpose: Consumes a required reserved word, or flags an error.
+//
+// *****************************************************************************
+//
+static void expectWord(struct Parser *p, const char *word)
+{
+    if(isWord(p, word))
+    {
+        consume(p);
+    }
+    else
+    {
+        unexpected(p);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void skipNewlines(struct Parser *p)
+//
+// Purpose: Skips line breaks where the grammar allows them (after && and ||,
+//          between "for x" and "do", and so on).
+//
+// *****************************************************************************
+//
+static void skipNewlines(struct Parser *p)
+{
+    while(p->tok.type == T_NEWLINE)
+    {
+        consume(p);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *newNode(struct Parser *p, int type)
+//
+// Purpose: Allocates a zeroed node of the given type from the arena.
+//
+// *****************************************************************************
+//
+static struct AstNode *newNode(struct Parser *p, int type)
+{
+    struct AstNode *node;
+
+    node = (struct AstNode *) arenaAlloc(p->arena, sizeof(struct AstNode));
+    node->type = type;
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static char **copyWords(struct Parser *p, char *words[], int numWords)
+//
+// Purpose: Moves a word list collected on the stack into the arena, adding
+//          the NULL terminator.
+//
+// *****************************************************************************
+//
+static char **copyWords(struct Parser *p, char *words[], int numWords)
+{
+    char **copy;
+
+    copy = (char **) arenaAlloc(p->arena, (numWords + 1) * sizeof(char *));
+    memcpy(copy, words, numWords * sizeof(char *));
+    copy[numWords] = NULL;
+
+    return copy;
+}
+
+
+// *****************************************************************************
+//
+// static int isName(const char *s, size_t len)
+//
+// Purpose: Tells whether s is a valid variable or function name.
+//
+// *****************************************************************************
+//
+static int isName(const char *s, size_t len)
+{
+    size_t i;
+
+    if(len == 0 || (s[0] >= '0' && s[0] <= '9'))
+    {
+        return 0;
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        if(!(s[i] == '_' || (s[i] >= 'a' && s[i] <= 'z') ||
+             (s[i] >= 'A' && s[i] <= 'Z') || (s[i] >= '0' && s[i] <= '9')))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseBody(struct Parser *p)
+//
+// Purpose: Parses a command list that must not be empty (the condition or
+//          body of a compound command).
+//
+// *****************************************************************************
+//
+static struct AstNode *parseBody(struct Parser *p)
+{
+    struct AstNode *list = parseList(p);
+
+    if(list == NULL)
+    {
+        unexpected(p);
+    }
+
+    return list;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseFuncDef(struct Parser *p, char *name)
+//
+// Purpose: Parses the rest of "name() compound-command" once the name has
+//          been consumed and the lookahead is the '('.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseFuncDef(struct Parser *p, char *name)
+{
+    struct AstNode *node = newNode(p, N_FUNCDEF);
+    size_t bodyStart;
+
+    if(!isName(name, strlen(name)))
+    {
+        failParse(p, "invalid function name");
+        return NULL;
+    }
+    node->name = name;
+
+    consume(p);                             // (
+    if(p->tok.type != T_RPAREN)
+    {
+        unexpected(p);
+        return NULL;
+    }
+    consume(p);                             // )
+    skipNewlines(p);
+
+    // The body has to be a compound command. Remember where its text starts
+    // so the function can keep its own copy after this statement is gone.
+    //
+    if(!(isWord(p, "{") || isWord(p, "if") || isWord(p, "while") ||
+         isWord(p, "until") || isWord(p, "for")))
+    {
+        if(p->tok.type == T_EOF)
+        {
+            unexpected(p);
+        }
+        else
+        {
+            failParse(p, "function body must be a compound command");
+        }
+        return NULL;
+    }
+
+    bodyStart = p->tok.start;
+    node->body = parseCommand(p);
+    node->src = p->src + bodyStart;
+    node->srcLen = p->prevEnd - bodyStart;
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseSimple(struct Parser *p)
+//
+// Purpose: Parses words and redirections up to the next operator. The first
+//          word followed by '(' turns the command into a function definition.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseSimple(struct Parser *p)
+{
+    struct AstNode *node = newNode(p, N_CMD);
+    char *words[MAX_ARGS];                  // Words collected so far
+    int numWords = 0;                       // Number of words collected
+    int redir;                              // T_LT or T_GT
+
+    for(;;)
+    {
+        if(p->tok.type == T_WORD)
+        {
+            if(numWords >= MAX_ARGS - 1)
+            {
+                failParse(p, "too many arguments");
+                return NULL;
+            }
+            words[numWords++] = arenaStrndup(p->arena, p->tok.text, p->tok.len);
+            consume(p);
+
+            if(numWords == 1 && p->tok.type == T_LPAREN &&
+               node->redirIn == NULL && node->redirOut == NULL)
+            {
+                return parseFuncDef(p, words[0]);
+            }
+        }
+        else if(p->tok.type == T_LT || p->tok.type == T_GT)
+        {
+            // A redirection operator must be followed by a file name.
+            //
+            redir = p->tok.type;
+            consume(p);
+            if(p->tok.type != T_WORD)
+            {
+                failParse(p, redir == T_LT ? "missing file name after `<'"
+                                           : "missing file name after `>'");
+                return NULL;
+            }
+            if(redir == T_LT)
+            {
+                node->redirIn = arenaStrndup(p->arena, p->tok.text, p->tok.len);
+            }
+            else
+            {
+                node->redirOut = arenaStrndup(p->arena, p->tok.text, p->tok.len);
+            }
+            consume(p);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    node->words = copyWords(p, words, numWords);
+    node->numWords = numWords;
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseIf(struct Parser *p)
+//
+// Purpose: Parses an if (or elif) command once "if"/"elif" is the lookahead.
+//          An elif becomes a nested N_IF in elseBody and shares the outer fi.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseIf(struct Parser *p)
+{
+    struct AstNode *node = newNode(p, N_IF);
+
+    consume(p);                             // if / elif
+    node->cond = parseBody(p);
+    expectWord(p, "then");
+    if(p->err != PARSE_OK)
+    {
+        return NULL;
+    }
+    node->body = parseBody(p);
+    if(p->err != PARSE_OK)
+    {
+        return NULL;
+    }
+
+    if(isWord(p, "elif"))
+    {
+        if(p->depth >= MAX_NEST)
+        {
+            failParse(p, "commands nested too deeply");
+            return NULL;
+        }
+        p->depth++;
+        node->elseBody = parseIf(p);
+        p->depth--;
+        return node;
+    }
+
+    if(isWord(p, "else"))
+    {
+        consume(p);
+        node->elseBody = parseBody(p);
+    }
+    expectWord(p, "fi");
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseWhile(struct Parser *p)
+//
+// Purpose: Parses a while or until loop.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseWhile(struct Parser *p)
+{
+    struct AstNode *node = newNode(p, isWord(p, "while") ? N_WHILE : N_UNTIL);
+
+    consume(p);                             // while / until
+    node->cond = parseBody(p);
+    expectWord(p, "do");
+    if(p->err != PARSE_OK)
+    {
+        return NULL;
+    }
+    node->body = parseBody(p);
+    expectWord(p, "done");
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseFor(struct Parser *p)
+//
+// Purpose: Parses "for name [in word...]; do list; done". Without "in" the
+//          loop runs over the positional parameters.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseFor(struct Parser *p)
+{
+    struct AstNode *node = newNode(p, N_FOR);
+    char *words[MAX_ARGS];                  // Loop items collected so far
+    int numWords = 0;                       // Number of loop items
+
+    consume(p);                             // for
+    if(p->tok.type != T_WORD || !isName(p->tok.text, p->tok.len))
+    {
+        if(p->tok.type == T_WORD)
+        {
+            failParse(p, "invalid for loop variable");
+        }
+        else
+        {
+            unexpected(p);
+        }
+        return NULL;
+    }
+    node->name = arenaStrndup(p->arena, p->tok.text, p->tok.len);
+    consume(p);
+    skipNewlines(p);
+
+    if(isWord(p, "in"))
+    {
+        consume(p);
+        node->hasIn = 1;
+        while(p->tok.type == T_WORD)
+        {
+            if(numWords >= MAX_ARGS - 1)
+            {
+                failParse(p, "too many arguments");
+                return NULL;
+            }
+            words[numWords++] = arenaStrndup(p->arena, p->tok.text, p->tok.len);
+            consume(p);
+        }
+
+        // The word list has to be ended by ';' or a newline before "do".
+        //
+        if(p->tok.type != T_SEMI && p->tok.type != T_NEWLINE)
+        {
+            unexpected(p);
+            return NULL;
+        }
+        consume(p);
+    }
+    else if(p->tok.type == T_SEMI)
+    {
+        consume(p);
+    }
+    node->words = copyWords(p, words, numWords);
+    node->numWords = numWords;
+
+    skipNewlines(p);
+    expectWord(p, "do");
+    if(p->err != PARSE_OK)
+    {
+        return NULL;
+    }
+    node->body = parseBody(p);
+    expectWord(p, "done");
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseCommand(struct Parser *p)
+//
+// Purpose: Parses one command: a compound command picked by its reserved
+//          word, or a simple command.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseCommand(struct Parser *p)
+{
+    struct AstNode *node = NULL;
+
+    // Deeply nested input could otherwise run the parser (and later the
+    // evaluator) out of stack.
+    //
+    if(p->depth >= MAX_NEST)
+    {
+        failParse(p, "commands nested too deeply");
+        return NULL;
+    }
+    p->depth++;
+
+    if(p->tok.type == T_LT || p->tok.type == T_GT)
+    {
+        node = parseSimple(p);
+    }
+    else if(p->tok.type != T_WORD || atListEnd(p))
+    {
+        unexpected(p);
+    }
+    else if(isWord(p, "if"))
+    {
+        node = parseIf(p);
+    }
+    else if(isWord(p, "while") || isWord(p, "until"))
+    {
+        node = parseWhile(p);
+    }
+    else if(isWord(p, "for"))
+    {
+        node = parseFor(p);
+    }
+    else if(isWord(p, "{"))
+    {
+        node = newNode(p, N_GROUP);
+        consume(p);
+        node->body = parseBody(p);
+        expectWord(p, "}");
+    }
+    else
+    {
+        node = parseSimple(p);
+    }
+
+    p->depth--;
+
+    return p->err == PARSE_OK ? node : NULL;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseAndOr(struct Parser *p)
+//
+// Purpose: Parses commands joined by && and ||, which group to the left.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseAndOr(struct Parser *p)
+{
+    struct AstNode *left;
+    struct AstNode *node;
+    int numOps = 0;                         // Operators in the chain so far
+
+    left = parseCommand(p);
+
+    while(p->err == PARSE_OK && (p->tok.type == T_AND || p->tok.type == T_OR))
+    {
+        // The chain nests to the left, and the evaluator recurses down it,
+        // so keep it from getting arbitrarily deep.
+        //
+        if(++numOps >= MAX_ARGS)
+        {
+            failParse(p, "too many && and || operators");
+            return NULL;
+        }
+        node = newNode(p, p->tok.type == T_AND ? N_AND : N_OR);
+        consume(p);
+        skipNewlines(p);
+        node->left = left;
+        node->right = parseCommand(p);
+        left = node;
+    }
+
+    return p->err == PARSE_OK ? left : NULL;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *parseList(struct Parser *p)
+//
+// Purpose: Parses commands separated by ';', '&' or newlines, stopping at
+//          the end of input or at a reserved word that closes a compound
+//          command. Returns NULL for an empty list.
+//
+// *****************************************************************************
+//
+static struct AstNode *parseList(struct Parser *p)
+{
+    struct AstNode *first = NULL;           // First command in the list
+    struct AstNode *last = NULL;            // Last command in the list
+    struct AstNode *node;                   // Command just parsed
+
+    skipNewlines(p);
+
+    while(p->err == PARSE_OK && !atListEnd(p))
+    {
+        node = parseAndOr(p);
+        if(node == NULL)
+        {
+            return NULL;
+        }
+
+        if(first == NULL)
+        {
+            first = node;
+        }
+        else
+        {
+            last->next = node;
+        }
+        last = node;
+
+        if(p->tok.type == T_AMP)
+        {
+            // Only simple commands can be sent to the background.
+            //
+            if(node->type != N_CMD)
+            {
+                failParse(p, "`&' only applies to simple commands");
+                return NULL;
+            }
+            node->bg = 1;
+            consume(p);
+        }
+        else if(p->tok.type == T_SEMI || p->tok.type == T_NEWLINE)
+        {
+            consume(p);
+        }
+        else
+        {
+            break;
+        }
+        skipNewlines(p);
+    }
+
+    return p->err == PARSE_OK ? first : NULL;
+}
+
+
+// *****************************************************************************
+//
+// int parseScript(const char *src, size_t len, struct Arena *arena,
+//                 struct AstNode **tree, char *errMsg, size_t errLen)
+//
+// Purpose: Parses a complete script into a command list.
+//
+// *****************************************************************************
+//
+int parseScript(const char *src, size_t len, struct Arena *arena,
+                struct AstNode **tree, char *errMsg, size_t errLen)
+{
+    struct Parser p;
+
+    memset(&p, 0, sizeof(p));
+    p.src = src;
+    p.len = len;
+    p.arena = arena;
+    p.err = PARSE_OK;
+    p.errMsg = errMsg;
+    p.errLen = errLen;
+    if(errLen > 0)
+    {
+        errMsg[0] = '\0';
+    }
+
+    nextToken(&p);
+    *tree = parseList(&p);
+
+    // Anything left over is a stray reserved word or ')'.
+    //
+    if(p.err == PARSE_OK && p.tok.type != T_EOF)
+    {
+        unexpected(&p);
+    }
+
+    if(p.err != PARSE_OK)
+    {
+        *tree = NULL;
+    }
+
+    return p.err;
+}
@@ -0,0 +1,96 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_post.c
+//
+//
+// Overview:
+//    smallsh-post: posts a progress (or, with -r, result) message for a
+//    background job to the shell's status ring, so scripts run as jobs can
+//    report progress without pipes or temp files. C programs can include
+//    smallsh_ring.h and call statusPost() directly instead.
+//
+// Input:
+//    smallsh-post [-r] [-p pid] message...
+//
+//    The message is about the job with the given PID, by default the
+//    process that ran smallsh-post (usually the script the shell started).
+//
+// Output:
+//    Nothing. Exits 1 if there is no status ring or it is full.
+//
+// *****************************************************************************
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "smallsh_ring.h"
+
+
+int main(int argc, char *argv[])
+{
+    struct StatusRing *ring;             // The shell's status ring
+    char msg[STATUS_MSG_MAX];            // Message built from the arguments
+    size_t len = 0;                      // Length of the message so far
+    size_t n;                            // Length of the current argument
+    int kind = STATUS_PROGRESS;          // Record kind
+    int pid = (int)getppid();            // Job the message is about
+    int opt;                             // Command line option letter
+
+    while((opt = getopt(argc, argv, "rp:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'r':
+                kind = STATUS_RESULT;
+                break;
+            case 'p':
+                pid = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-r] [-p pid] message...\n", argv[0]);
+                exit(2);
+        }
+    }
+
+    ring = statusRingAttach();
+    if(ring == NULL)
+    {
+        fprintf(stderr, "%s: no smallsh status ring (%s not set)\n", argv[0], STATUS_RING_ENV);
+        exit(1);
+    }
+
+    // Join the remaining arguments with spaces, cutting the message short
+    // if it does not fit.
+    //
+    msg[0] = '\0';
+    for(; optind < argc; optind++)
+    {
+        n = strlen(argv[optind]);
+        if(len > 0 && len < sizeof(msg) - 1)
+        {
+            msg[len++] = ' ';
+        }
+        if(n > sizeof(msg) - 1 - len)
+        {
+            n = sizeof(msg) - 1 - len;
+        }
+        memcpy(msg + len, argv[optind], n);
+        len += n;
+        msg[len] = '\0';
+    }
+
+    if(statusPost(ring, pid, kind, msg) == -1)
+    {
+        fprintf(stderr, "%s: status ring is full\n", argv[0]);
+        exit(1);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,83 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_proto.h
+//
+//
+// Overview:
+//    Wire format of server mode ('smallsh -l socket'), shared by the shell
+//    and smallsh-client.
+//
+//    Everything on the Unix-domain socket is a frame: a header followed by
+//    len bytes of payload. Integers are in host byte order (both ends are
+//    on the same machine).
+//
+//    A client builds a request out of frames carrying the same request id,
+//    then sends FRAME_RUN to start it:
+//
+//       FRAME_ARG    one argument (the first one is the program)
+//       FRAME_ENV    one NAME=value environment variable to set
+//       FRAME_CWD    directory to run in
+//       FRAME_STDIN  bytes for the program's stdin (may be repeated)
+//       FRAME_RUN    request is complete, start it (empty payload)
+//
+//    The shell answers with frames carrying the same id:
+//
+//       FRAME_STDOUT / FRAME_STDERR  output, as it is produced
+//       FRAME_EXIT   4-byte exit code (128 + signal number if killed);
+//                    always the last frame for the request
+//       FRAME_ERROR  the request was rejected (message text); also final
+//
+//    Frames for a request that was rejected are ignored up to and
+//    including its FRAME_RUN, as are frames for a request that is running.
+//
+//    Any number of requests, with different ids, may run at once on one
+//    connection, and the frames of different requests are interleaved. An
+//    id can be reused once its final frame has arrived. A connection may
+//    have at most MAX_PENDING requests that have not been started yet; the
+//    shell hangs up on one that opens more.
+//
+// *****************************************************************************
+//
+
+
+#ifndef SMALLSH_PROTO_H
+#define SMALLSH_PROTO_H
+
+
+#include <stdint.h>
+
+
+#define FRAME_ARG     'A'
+#define FRAME_ENV     'E'
+#define FRAME_CWD     'C'
+#define FRAME_STDIN   'I'
+#define FRAME_RUN     'R'
+#define FRAME_STDOUT  'o'
+#define FRAME_STDERR  'e'
+#define FRAME_EXIT    'x'
+#define FRAME_ERROR   '!'
+
+#define FRAME_MAX_PAYLOAD (1024 * 1024)   // Largest payload either side sends
+#define MAX_PENDING       64              // Unstarted requests per connection
+
+
+// struct FrameHeader: Precedes every frame's payload
+//
+// type -> One of the FRAME_* codes
+//
+// id   -> Request the frame belongs to (chosen by the client)
+//
+// len  -> Payload length in bytes
+//
+struct FrameHeader {
+    uint32_t type;
+    uint32_t id;
+    uint32_t len;
+};
+
+
+#endif
@@ -0,0 +1,231 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_ring.h
+//
+//
+// Overview:
+//    Layout of the shared-memory status ring, and the functions programs
+//    started by the shell use to post to it.
+//
+//    The shell creates the ring in a memfd just before it starts its first
+//    program; every child inherits it, and finds the descriptor number in
+//    the SMALLSH_STATUS_FD environment variable. Any number of processes
+//    may post progress or result records; the shell is the only reader and
+//    shows the latest ones in 'jobs'. Posting takes no locks, and its only
+//    system call is getpid().
+//
+//    This header has no dependencies on the rest of the shell, so other
+//    programs can include it on its own.
+//
+// *****************************************************************************
+//
+
+
+#ifndef SMALLSH_RING_H
+#define SMALLSH_RING_H
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+#define STATUS_RING_ENV   "SMALLSH_STATUS_FD" // Env var holding the ring's fd
+#define STATUS_RING_MAGIC 0x32534d53u         // "SMS2" (slot layout 2)
+#define STATUS_RING_SLOTS 256                 // Slots (a power of two)
+#define STATUS_MSG_MAX    112                 // Message bytes incl. NUL
+
+#define STATUS_PROGRESS   1                   // Record kind: progress update
+#define STATUS_RESULT     2                   // Record kind: final result
+
+
+// Slot state: a sequence number in the high 32 bits and the PID of the
+// process that claimed the slot (0 while unclaimed) in the low 32 bits, so
+// both change together.
+//
+#define STATUS_STATE(seq, owner) (((unsigned long long)(seq) << 32) | \
+                                  (unsigned int)(owner))
+#define STATUS_SEQ(state)        ((unsigned int)((state) >> 32))
+#define STATUS_OWNER(state)      ((int)((state) & 0xffffffffu))
+
+
+// struct StatusSlot: One record in the ring (128 bytes)
+//
+// state -> Whose turn it is. Slot i starts at sequence number i. A poster
+//          holding ticket pos claims the slot by setting its own PID while
+//          the sequence number is pos, and publishes the record by moving
+//          it to pos + 1. The shell sets pos + STATUS_RING_SLOTS (no owner)
+//          once it has read the record, or once the owner has died without
+//          publishing it.
+//
+// pid   -> Job the record is about
+//
+// kind  -> STATUS_PROGRESS or STATUS_RESULT
+//
+// msg   -> NUL-terminated message text
+//
+struct StatusSlot {
+    _Atomic unsigned long long state;
+    int pid;
+    int kind;
+    char msg[STATUS_MSG_MAX];
+};
+
+// struct StatusRing: The whole shared region
+//
+// tail -> Next ticket to hand to a poster (the shell keeps its own read
+//         position privately). Bumped after the slot is claimed, by the
+//         claimer or by any poster that finds it claimed.
+//
+struct StatusRing {
+    unsigned int magic;
+    unsigned int slots;
+    _Atomic unsigned int tail;
+    char pad[52];
+    struct StatusSlot slot[STATUS_RING_SLOTS];
+};
+
+
+// *****************************************************************************
+//
+// static inline struct StatusRing *statusRingAttach(void)
+//
+//    Entry:   None.
+//
+//    Exit:    Returns the shell's status ring, or NULL if this process was not
+//             started by the shell (or the ring cannot be mapped).
+//
+//    Purpose: Map the ring advertised in SMALLSH_STATUS_FD.
+//
+// *****************************************************************************
+//
+static inline struct StatusRing *statusRingAttach(void)
+{
+    const char *env = getenv(STATUS_RING_ENV);
+    struct StatusRing *ring;
+    char *end;
+    long fd;
+
+    if(env == NULL || *env == '\0')
+    {
+        return NULL;
+    }
+    fd = strtol(env, &end, 10);
+    if(*end != '\0' || fd < 0)
+    {
+        return NULL;
+    }
+
+    ring = (struct StatusRing *) mmap(NULL, sizeof(struct StatusRing),
+                                      PROT_READ | PROT_WRITE, MAP_SHARED, (int)fd, 0);
+    if(ring == MAP_FAILED)
+    {
+        return NULL;
+    }
+    if(ring->magic != STATUS_RING_MAGIC || ring->slots != STATUS_RING_SLOTS)
+    {
+        munmap(ring, sizeof(struct StatusRing));
+        return NULL;
+    }
+
+    return ring;
+}
+
+
+// *****************************************************************************
+//
+// static inline int statusPost(struct StatusRing *ring, int pid, int kind,
+//                              const char *msg)
+//
+//    Entry:   struct StatusRing *ring
+//                Ring returned by statusRingAttach().
+//             int pid
+//                Job the record is about (usually the poster's own PID).
+//             int kind
+//                STATUS_PROGRESS or STATUS_RESULT.
+//             const char *msg
+//                Message text; cut to STATUS_MSG_MAX - 1 bytes.
+//
+//    Exit:    Returns 0 if the record was posted, -1 if the ring was full.
+//
+//    Purpose: Post a record. Safe to call from many processes at once.
+//
+// *****************************************************************************
+//
+static inline int statusPost(struct StatusRing *ring, int pid, int kind,
+                             const char *msg)
+{
+    struct StatusSlot *slot;
+    unsigned long long state;
+    unsigned int pos;
+    unsigned int expect;
+    int me = (int)getpid();
+    size_t len;
+
+    // Claim the slot for the next ticket. It is free for ticket pos when
+    // its sequence number is pos and nobody owns it. If its sequence number
+    // is still behind, the shell has not read the record from one lap ago
+    // and the ring is full. The owner is set in the same step, so the shell
+    // knows whom to wait for, and nobody else can write the slot until the
+    // record is published or the owner has died.
+    //
+    for(;;)
+    {
+        pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        slot = &ring->slot[pos % STATUS_RING_SLOTS];
+        state = atomic_load_explicit(&slot->state, memory_order_acquire);
+
+        if(STATUS_SEQ(state) == pos && STATUS_OWNER(state) == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&slot->state, &state,
+                                                     STATUS_STATE(pos, me),
+                                                     memory_order_acquire,
+                                                     memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(STATUS_SEQ(state) == pos)
+        {
+            // Claimed, but the claimer has not moved the tail on yet.
+            //
+            atomic_compare_exchange_strong_explicit(&ring->tail, &pos, pos + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed);
+        }
+        else if((int)(STATUS_SEQ(state) - pos) < 0)
+        {
+            return -1;
+        }
+    }
+    expect = pos;
+    atomic_compare_exchange_strong_explicit(&ring->tail, &expect, pos + 1,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+
+    // Fill in the record, then publish it to the shell.
+    //
+    len = strlen(msg);
+    if(len > STATUS_MSG_MAX - 1)
+    {
+        len = STATUS_MSG_MAX - 1;
+    }
+    slot->pid = pid;
+    slot->kind = kind;
+    memcpy(slot->msg, msg, len);
+    slot->msg[len] = '\0';
+
+    atomic_store_explicit(&slot->state, STATUS_STATE(pos + 1, me),
+                          memory_order_release);
+
+    return 0;
+}
+
+
+#endif
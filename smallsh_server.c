@@ -0,0 +1,1170 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  smallsh_server.c
+//
+//
+// Overview:
+//    Basic shell with built-in commands, basic signal handling, and a small
+//    script language.
+//
+//    This file contains server mode: instead of reading commands from the
+//    user, the shell listens on a Unix-domain socket and runs framed command
+//    requests (see smallsh_proto.h). Every request is fork()'d and exec()'d
+//    like a background job, so any number can run at once; their stdout,
+//    stderr and exit status are streamed back as they happen.
+//
+//    One thread drives everything through the completion-style I/O layer
+//    (smallsh_io.h, io_uring or epoll): the listening socket, client
+//    connections, the pipes to and from each running program, and a
+//    signalfd that reports SIGCHLD (and SIGINT/SIGTERM, which stop the
+//    server).
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // pipe2()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "smallsh.h"
+#include "smallsh_io.h"
+#include "smallsh_proto.h"
+
+
+#define MAX_STDIN      (64 * 1024 * 1024) // Largest stdin payload per request
+#define WBUF_HIGH      (4 * 1024 * 1024)  // Stop reading programs' output...
+#define WBUF_LOW       (1024 * 1024)      // ...until the client catches up
+
+
+// What an I/O watch refers to
+//
+enum WatchKind {
+    W_LISTEN,            // listening socket
+    W_SIGNAL,            // signalfd
+    W_CONN,              // client connection
+    W_STDIN,             // pipe to a program's stdin
+    W_STDOUT,            // pipe from a program's stdout
+    W_STDERR             // pipe from a program's stderr
+};
+
+struct Conn;
+struct Request;
+
+// struct Watch: A descriptor and what it belongs to. io comes first so the
+//               I/O layer's callback can cast back to the Watch.
+//
+struct Watch {
+    struct IoWatch io;
+    int kind;
+    struct Conn *conn;
+    struct Request *req;
+};
+
+// struct Buf: A growable byte buffer; bytes before off have been consumed
+//
+struct Buf {
+    char *data;
+    size_t len;
+    size_t off;
+    size_t cap;
+};
+
+// struct Request: One command request from a client
+//
+struct Request {
+    uint32_t id;                // Client's request id
+    struct Conn *conn;          // Connection the request came in on
+    char *argv[MAX_ARGS];       // Program and arguments
+    int argc;
+    char *env[MAX_ARGS];        // NAME=value settings
+    int numEnv;
+    char *cwd;                  // Directory to run in, or NULL
+    struct Buf in;              // stdin payload
+    char running;               // Program has been started
+    char rejected;              // An error frame was sent; frames are
+                                // dropped until FRAME_RUN ends the request
+    char exited;                // Program has been reaped
+    pid_t pid;                  // Program's PID
+    int status;                 // waitpid() status once reaped
+    struct Watch inW;           // Pipe to the program's stdin
+    struct Watch outW;          // Pipe from the program's stdout
+    struct Watch errW;          // Pipe from the program's stderr
+    struct Request *next;       // Next request on the connection
+};
+
+// struct Conn: A client connection
+//
+// Frames are queued in wbuf while sending (which the kernel may be reading
+// from) goes out; the two are swapped when sending is done.
+//
+struct Conn {
+    struct Watch w;             // The socket (closed once the client is gone)
+    struct Buf rbuf;            // Bytes received, not yet parsed
+    struct Buf wbuf;            // Frames waiting to be sent
+    struct Buf sending;         // Frames being sent
+    char paused;                // Output pipes paused for backpressure
+    int pending;                // Requests not started yet
+    struct Request *reqs;       // Requests being built or running
+    struct Conn *next;          // Next connection
+};
+
+
+static struct Conn *conns;              // All connections
+static struct Request *deadReqs;        // Finished requests, freed later
+static struct Conn *deadConns;          // Closed connections, freed later
+static sigset_t savedMask;              // Signal mask to give programs
+static int running;                     // Cleared by SIGINT/SIGTERM
+static int acceptPaused;                // Out of descriptors; not accepting
+static struct Watch listenW = { .kind = W_LISTEN };
+static struct Watch signalW = { .kind = W_SIGNAL };
+
+
+// *****************************************************************************
+//
+// static void bufAppend(struct Buf *buf, const void *data, size_t len)
+//
+// Purpose: Appends bytes to a buffer, compacting or growing it as needed.
+//
+// *****************************************************************************
+//
+static void bufAppend(struct Buf *buf, const void *data, size_t len)
+{
+    // Slide unconsumed bytes to the front before growing.
+    //
+    if(buf->off > 0 && buf->len + len > buf->cap)
+    {
+        memmove(buf->data, buf->data + buf->off, buf->len - buf->off);
+        buf->len -= buf->off;
+        buf->off = 0;
+    }
+
+    if(buf->len + len > buf->cap)
+    {
+        buf->cap = (buf->len + len) * 2;
+        buf->data = (char *) realloc(buf->data, buf->cap);
+        if(buf->data == NULL)
+        {
+            perror("Server buffer allocation failed");
+            exit(1);
+        }
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+
+// *****************************************************************************
+//
+// static void bufFree(struct Buf *buf)
+//
+// Purpose: Frees a buffer's memory and empties it.
+//
+// *****************************************************************************
+//
+static void bufFree(struct Buf *buf)
+{
+    free(buf->data);
+    memset(buf, 0, sizeof(*buf));
+}
+
+
+// *****************************************************************************
+//
+// static size_t queued(struct Conn *conn)
+//
+// Purpose: Returns how many bytes are waiting to go to a client (none once
+//          it has hung up; whatever was queued is being thrown away).
+//
+// *****************************************************************************
+//
+static size_t queued(struct Conn *conn)
+{
+    if(conn->w.io.fd < 0)
+    {
+        return 0;
+    }
+    return conn->wbuf.len + conn->sending.len - conn->sending.off;
+}
+
+
+// *****************************************************************************
+//
+// static void flushConn(struct Conn *conn)
+//
+// Purpose: Starts sending queued frames if nothing is being sent, and
+//          resumes paused output pipes once the backlog is small again.
+//
+// *****************************************************************************
+//
+static void flushConn(struct Conn *conn)
+{
+    struct Request *req;
+    struct Buf tmp;
+
+    if(conn->w.io.fd >= 0 && !conn->w.io.armed[IO_WRITE])
+    {
+        if(conn->sending.off == conn->sending.len && conn->wbuf.len > 0)
+        {
+            tmp = conn->sending;
+            conn->sending = conn->wbuf;
+            conn->wbuf = tmp;
+            conn->wbuf.len = conn->wbuf.off = 0;
+        }
+        if(conn->sending.off < conn->sending.len)
+        {
+            ioWrite(&conn->w.io, conn->sending.data + conn->sending.off,
+                    conn->sending.len - conn->sending.off);
+        }
+    }
+
+    if(conn->paused && queued(conn) < WBUF_LOW)
+    {
+        conn->paused = 0;
+        for(req = conn->reqs; req != NULL; req = req->next)
+        {
+            ioRead(&req->outW.io);
+            ioRead(&req->errW.io);
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void sendFrame(struct Conn *conn, uint32_t type, uint32_t id,
+//                       const void *data, size_t len)
+//
+// Purpose: Queues a frame for the client. Output for a client that has hung
+//          up is thrown away.
+//
+// *****************************************************************************
+//
+static void sendFrame(struct Conn *conn, uint32_t type, uint32_t id,
+                      const void *data, size_t len)
+{
+    struct FrameHeader hdr;
+
+    if(conn->w.io.fd < 0)
+    {
+        return;
+    }
+
+    hdr.type = type;
+    hdr.id = id;
+    hdr.len = (uint32_t)len;
+    bufAppend(&conn->wbuf, &hdr, sizeof(hdr));
+    bufAppend(&conn->wbuf, data, len);
+}
+
+
+// *****************************************************************************
+//
+// static void closeWatch(struct Watch *w)
+//
+// Purpose: Closes a watch's descriptor. If accepting was stopped because
+//          the process ran out of descriptors, one is free now, so the
+//          listener is armed again.
+//
+// *****************************************************************************
+//
+static void closeWatch(struct Watch *w)
+{
+    if(w->io.fd < 0)
+    {
+        return;
+    }
+    ioClose(&w->io);
+
+    if(acceptPaused)
+    {
+        acceptPaused = 0;
+        ioRead(&listenW.io);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void freeRequest(struct Request *req)
+//
+// Purpose: Unlinks a request from its connection and closes its pipes. The
+//          request is freed by freeDead() once the kernel is done with it.
+//
+// *****************************************************************************
+//
+static void freeRequest(struct Request *req)
+{
+    struct Request **pp;
+
+    for(pp = &req->conn->reqs; *pp != NULL; pp = &(*pp)->next)
+    {
+        if(*pp == req)
+        {
+            *pp = req->next;
+            break;
+        }
+    }
+
+    if(!req->running)
+    {
+        req->conn->pending--;
+    }
+    closeWatch(&req->inW);
+    closeWatch(&req->outW);
+    closeWatch(&req->errW);
+    req->next = deadReqs;
+    deadReqs = req;
+}
+
+
+// *****************************************************************************
+//
+// static void rejectRequest(struct Request *req, const char *msg)
+//
+// Purpose: Sends an error frame for a request that cannot run. The error
+//          frame is the request's last, so the request is kept (marked
+//          rejected) to swallow the rest of its frames; the client's
+//          FRAME_RUN ends it and frees the id.
+//
+// *****************************************************************************
+//
+static void rejectRequest(struct Request *req, const char *msg)
+{
+    sendFrame(req->conn, FRAME_ERROR, req->id, msg, strlen(msg));
+    req->rejected = 1;
+}
+
+
+// *****************************************************************************
+//
+// static void finishRequest(struct Request *req)
+//
+// Purpose: Sends the exit frame once the program has been reaped and all of
+//          its output has been forwarded, then frees the request.
+//
+// *****************************************************************************
+//
+static void finishRequest(struct Request *req)
+{
+    int32_t code;
+
+    if(!req->exited || req->outW.io.fd >= 0 || req->errW.io.fd >= 0)
+    {
+        return;
+    }
+
+    code = exitCode(req->status);
+    sendFrame(req->conn, FRAME_EXIT, req->id, &code, sizeof(code));
+    flushConn(req->conn);
+    freeRequest(req);
+}
+
+
+// *****************************************************************************
+//
+// static void startRequest(struct Request *req)
+//
+// Purpose: Forks and execs a request's program with pipes for its stdin,
+//          stdout and stderr.
+//
+// *****************************************************************************
+//
+static void startRequest(struct Request *req)
+{
+    int inPipe[2] = { -1, -1 };     // Pipe to the program's stdin
+    int outPipe[2];                 // Pipe from the program's stdout
+    int errPipe[2];                 // Pipe from the program's stderr
+    int fdIn;                       // Program's stdin
+    int i;
+
+    // O_CLOEXEC so no program inherits another request's pipes.
+    //
+    if(pipe2(outPipe, O_CLOEXEC) == -1)
+    {
+        rejectRequest(req, strerror(errno));
+        return;
+    }
+    if(pipe2(errPipe, O_CLOEXEC) == -1)
+    {
+        close(outPipe[0]);
+        close(outPipe[1]);
+        rejectRequest(req, strerror(errno));
+        return;
+    }
+    if(req->in.len > 0 && pipe2(inPipe, O_CLOEXEC) == -1)
+    {
+        close(outPipe[0]);
+        close(outPipe[1]);
+        close(errPipe[0]);
+        close(errPipe[1]);
+        rejectRequest(req, strerror(errno));
+        return;
+    }
+
+    req->argv[req->argc] = NULL;
+    req->pid = fork();
+
+    if((int)req->pid < 0)
+    {
+        perror("Fork failed.");
+        exit(1);
+    }
+    else if((int)req->pid == 0)
+    {
+        // This section of the code will only be seen by the fork()'d
+        // child process. Give it the signal handling a program started
+        // from the prompt would get.
+        //
+        sigprocmask(SIG_SETMASK, &savedMask, NULL);
+        signal(SIGPIPE, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+
+        // stdin is the payload pipe, or /dev/null if there was no payload.
+        //
+        fdIn = inPipe[0] >= 0 ? inPipe[0] : open("/dev/null", O_RDONLY);
+        if(fdIn < 0 || dup2(fdIn, STDIN_FILENO) == -1 ||
+           dup2(outPipe[1], STDOUT_FILENO) == -1 ||
+           dup2(errPipe[1], STDERR_FILENO) == -1)
+        {
+            perror("Request dup2()");
+            _exit(1);
+        }
+
+        if(req->cwd != NULL && chdir(req->cwd) == -1)
+        {
+            perror(req->cwd);
+            _exit(1);
+        }
+        for(i = 0; i < req->numEnv; i++)
+        {
+            putenv(req->env[i]);
+        }
+
+        execvp(req->argv[0], req->argv);
+
+        // If an error occurred, as always exit with a descriptive message.
+        //
+        perror("Exec failed");
+        _exit(1);
+    }
+
+    // Parent: keep our ends of the pipes, close the rest.
+    //
+    req->running = 1;
+    req->conn->pending--;
+    close(outPipe[1]);
+    close(errPipe[1]);
+    ioAdd(&req->outW.io, outPipe[0], 0);
+    ioAdd(&req->errW.io, errPipe[0], 0);
+    if(!req->conn->paused)
+    {
+        ioRead(&req->outW.io);
+        ioRead(&req->errW.io);
+    }
+
+    if(inPipe[0] >= 0)
+    {
+        close(inPipe[0]);
+        ioAdd(&req->inW.io, inPipe[1], 0);
+        ioWrite(&req->inW.io, req->in.data, req->in.len);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static struct Request *findRequest(struct Conn *conn, uint32_t id)
+//
+// Purpose: Finds a connection's request by id.
+//
+// *****************************************************************************
+//
+static struct Request *findRequest(struct Conn *conn, uint32_t id)
+{
+    struct Request *req;
+
+    for(req = conn->reqs; req != NULL; req = req->next)
+    {
+        if(req->id == id)
+        {
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+
+// *****************************************************************************
+//
+// static int handleFrame(struct Conn *conn, struct FrameHeader *hdr,
+//                        const char *payload)
+//
+// Purpose: Adds one client frame to the request it belongs to, starting
+//          the request on FRAME_RUN. Returns -1 if the client has more
+//          unstarted requests than it may, 0 otherwise.
+//
+// *****************************************************************************
+//
+static int handleFrame(struct Conn *conn, struct FrameHeader *hdr,
+                       const char *payload)
+{
+    struct Request *req = findRequest(conn, hdr->id);
+    char *str;
+
+    // Frames for a request that is running, or was rejected, are ignored:
+    // the client has already been sent (or will be sent) the request's
+    // final frame, and nothing may follow it. FRAME_RUN ends a rejected
+    // request.
+    //
+    if(req != NULL && (req->running || req->rejected))
+    {
+        if(req->rejected && hdr->type == FRAME_RUN)
+        {
+            freeRequest(req);
+        }
+        return 0;
+    }
+
+    if(req == NULL)
+    {
+        // Each request being built holds memory (and maybe a large stdin
+        // payload) until FRAME_RUN, so a client only gets so many.
+        //
+        if(conn->pending >= MAX_PENDING)
+        {
+            return -1;
+        }
+        req = (struct Request *) calloc(1, sizeof(struct Request));
+        if(req == NULL)
+        {
+            perror("Request allocation failed");
+            exit(1);
+        }
+        req->id = hdr->id;
+        req->conn = conn;
+        req->inW.kind = W_STDIN;
+        req->outW.kind = W_STDOUT;
+        req->errW.kind = W_STDERR;
+        req->inW.req = req->outW.req = req->errW.req = req;
+        req->inW.io.fd = req->outW.io.fd = req->errW.io.fd = -1;
+        req->next = conn->reqs;
+        conn->reqs = req;
+        conn->pending++;
+    }
+
+    switch(hdr->type)
+    {
+        case FRAME_ARG:
+        case FRAME_ENV:
+        case FRAME_CWD:
+            str = strndup(payload, hdr->len);
+            if(str == NULL)
+            {
+                perror("Request allocation failed");
+                exit(1);
+            }
+            if(hdr->type == FRAME_CWD)
+            {
+                free(req->cwd);
+                req->cwd = str;
+            }
+            else if(hdr->type == FRAME_ARG && req->argc < MAX_ARGS - 1)
+            {
+                req->argv[req->argc++] = str;
+            }
+            else if(hdr->type == FRAME_ENV && req->numEnv < MAX_ARGS &&
+                    strchr(str, '=') != NULL && str[0] != '=')
+            {
+                req->env[req->numEnv++] = str;
+            }
+            else
+            {
+                free(str);
+                rejectRequest(req, hdr->type == FRAME_ARG ? "too many arguments" :
+                                   req->numEnv >= MAX_ARGS ? "too many environment settings" :
+                                                             "bad environment setting");
+            }
+            break;
+        case FRAME_STDIN:
+            if(req->in.len + hdr->len > MAX_STDIN)
+            {
+                rejectRequest(req, "stdin payload too large");
+                break;
+            }
+            bufAppend(&req->in, payload, hdr->len);
+            break;
+        case FRAME_RUN:
+            if(req->argc == 0)
+            {
+                rejectRequest(req, "no command");
+            }
+            else
+            {
+                startRequest(req);
+            }
+
+            // This was the request's last frame; if it did not start, its
+            // id is free again.
+            //
+            if(req->rejected)
+            {
+                freeRequest(req);
+            }
+            break;
+        default:
+            rejectRequest(req, "unknown frame type");
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static void hangUp(struct Conn *conn)
+//
+// Purpose: Handles a client that went away (or broke the protocol): closes
+//          the socket, drops requests that never started, and kills the
+//          ones still running. The connection is freed once they have been
+//          reaped.
+//
+// *****************************************************************************
+//
+static void hangUp(struct Conn *conn)
+{
+    struct Request *req;
+    struct Request *next;
+
+    closeWatch(&conn->w);
+    bufFree(&conn->rbuf);
+    bufFree(&conn->wbuf);
+
+    // Resume paused output pipes so the programs are not left blocked on a
+    // full pipe; what they write from now on is thrown away.
+    //
+    flushConn(conn);
+
+    for(req = conn->reqs; req != NULL; req = next)
+    {
+        next = req->next;
+        if(!req->running)
+        {
+            freeRequest(req);
+        }
+        else if(!req->exited)
+        {
+            kill(req->pid, SIGTERM);
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void freeConnIfDone(struct Conn *conn)
+//
+// Purpose: Retires a hung-up connection once none of its requests are
+//          left (freeDead() frees it).
+//
+// *****************************************************************************
+//
+static void freeConnIfDone(struct Conn *conn)
+{
+    struct Conn **pp;
+
+    if(conn->w.io.fd >= 0 || conn->reqs != NULL)
+    {
+        return;
+    }
+
+    for(pp = &conns; *pp != NULL; pp = &(*pp)->next)
+    {
+        if(*pp == conn)
+        {
+            *pp = conn->next;
+            conn->next = deadConns;
+            deadConns = conn;
+            break;
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void freeDead(void)
+//
+// Purpose: Frees the retired requests and connections the kernel no longer
+//          holds operations for (with io_uring, a cancelled read or write
+//          still completes later). Called between rounds of ioWait(), so no
+//          completion for them is being handled.
+//
+// *****************************************************************************
+//
+static void freeDead(void)
+{
+    struct Request **rp = &deadReqs;
+    struct Conn **cp = &deadConns;
+    struct Request *req;
+    struct Conn *conn;
+    int i;
+
+    while((req = *rp) != NULL)
+    {
+        if(ioBusy(&req->inW.io) || ioBusy(&req->outW.io) || ioBusy(&req->errW.io))
+        {
+            rp = &req->next;
+            continue;
+        }
+        *rp = req->next;
+        for(i = 0; i < req->argc; i++)
+        {
+            free(req->argv[i]);
+        }
+        for(i = 0; i < req->numEnv; i++)
+        {
+            free(req->env[i]);
+        }
+        free(req->cwd);
+        bufFree(&req->in);
+        free(req);
+    }
+
+    while((conn = *cp) != NULL)
+    {
+        if(ioBusy(&conn->w.io))
+        {
+            cp = &conn->next;
+            continue;
+        }
+        *cp = conn->next;
+        bufFree(&conn->sending);
+        free(conn);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void readConn(struct Conn *conn, ssize_t res, char *data)
+//
+// Purpose: Handles bytes from a client: every complete frame is acted on.
+//
+// *****************************************************************************
+//
+static void readConn(struct Conn *conn, ssize_t res, char *data)
+{
+    struct FrameHeader hdr;
+
+    if(res <= 0)
+    {
+        hangUp(conn);
+        return;
+    }
+    bufAppend(&conn->rbuf, data, res);
+
+    while(conn->rbuf.len - conn->rbuf.off >= sizeof(hdr))
+    {
+        memcpy(&hdr, conn->rbuf.data + conn->rbuf.off, sizeof(hdr));
+        if(hdr.len > FRAME_MAX_PAYLOAD)
+        {
+            // Not a client we can talk to.
+            //
+            hangUp(conn);
+            return;
+        }
+        if(conn->rbuf.len - conn->rbuf.off < sizeof(hdr) + hdr.len)
+        {
+            break;
+        }
+        if(handleFrame(conn, &hdr, conn->rbuf.data + conn->rbuf.off + sizeof(hdr)) == -1)
+        {
+            hangUp(conn);
+            return;
+        }
+        conn->rbuf.off += sizeof(hdr) + hdr.len;
+    }
+
+    if(conn->rbuf.off == conn->rbuf.len)
+    {
+        conn->rbuf.off = conn->rbuf.len = 0;
+    }
+
+    ioRead(&conn->w.io);
+    flushConn(conn);
+}
+
+
+// *****************************************************************************
+//
+// static void connWritten(struct Conn *conn, ssize_t res)
+//
+// Purpose: Accounts for frames sent to a client and sends more.
+//
+// *****************************************************************************
+//
+static void connWritten(struct Conn *conn, ssize_t res)
+{
+    if(res < 0)
+    {
+        hangUp(conn);
+        return;
+    }
+
+    conn->sending.off += res;
+    if(conn->sending.off == conn->sending.len)
+    {
+        conn->sending.off = conn->sending.len = 0;
+    }
+    flushConn(conn);
+}
+
+
+// *****************************************************************************
+//
+// static void readOutput(struct Watch *w, ssize_t res, char *data)
+//
+// Purpose: Forwards a program's stdout or stderr to its client. At end of
+//          file the pipe is closed and the request may be finished.
+//
+// *****************************************************************************
+//
+static void readOutput(struct Watch *w, ssize_t res, char *data)
+{
+    struct Request *req = w->req;
+    struct Conn *conn = req->conn;
+
+    if(res <= 0)
+    {
+        closeWatch(w);
+        finishRequest(req);
+        freeConnIfDone(conn);
+        return;
+    }
+
+    sendFrame(conn, w->kind == W_STDOUT ? FRAME_STDOUT : FRAME_STDERR,
+              req->id, data, res);
+    flushConn(conn);
+
+    // The client is not keeping up: stop reading output until it does.
+    // Pipes simply are not read again; flushConn() resumes them.
+    //
+    if(queued(conn) > WBUF_HIGH)
+    {
+        conn->paused = 1;
+    }
+    if(!conn->paused)
+    {
+        ioRead(&w->io);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void writeInput(struct Watch *w, ssize_t res)
+//
+// Purpose: Feeds a program its stdin payload; closes the pipe when all of
+//          it has been written (or the program stopped reading).
+//
+// *****************************************************************************
+//
+static void writeInput(struct Watch *w, ssize_t res)
+{
+    struct Buf *in = &w->req->in;
+
+    if(res > 0)
+    {
+        in->off += res;
+    }
+    if(res > 0 && in->off < in->len)
+    {
+        ioWrite(&w->io, in->data + in->off, in->len - in->off);
+        return;
+    }
+
+    closeWatch(w);
+}
+
+
+// *****************************************************************************
+//
+// static void reapRequests(void)
+//
+// Purpose: Reaps every finished program and finishes its request.
+//
+// *****************************************************************************
+//
+static void reapRequests(void)
+{
+    struct Conn *conn;
+    struct Conn *nextConn;
+    struct Request *req;
+    int status;
+    pid_t pid;
+
+    while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for(conn = conns; conn != NULL; conn = nextConn)
+        {
+            nextConn = conn->next;
+            for(req = conn->reqs; req != NULL; req = req->next)
+            {
+                if(req->running && req->pid == pid)
+                {
+                    req->exited = 1;
+                    req->status = status;
+                    finishRequest(req);
+                    freeConnIfDone(conn);
+                    nextConn = NULL;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void acceptConn(ssize_t res)
+//
+// Purpose: Sets up a newly accepted client connection. If accept() failed
+//          for lack of descriptors (or memory), the listener is left idle
+//          until closeWatch() frees one: re-arming it straight away would
+//          fail the same way, over and over, while the pending connection
+//          stays queued.
+//
+// *****************************************************************************
+//
+static void acceptConn(ssize_t res)
+{
+    static int warned;            // Running out was reported already
+    struct Conn *conn;
+
+    if(res < 0 && res != -EINTR && res != -ECONNABORTED)
+    {
+        if(!warned)
+        {
+            warned = 1;
+            fprintf(stderr, "smallsh: accept: %s; waiting for a connection "
+                            "to close\n", strerror((int)-res));
+        }
+        acceptPaused = 1;
+        return;
+    }
+    ioRead(&listenW.io);
+    if(res < 0)
+    {
+        return;
+    }
+
+    conn = (struct Conn *) calloc(1, sizeof(struct Conn));
+    if(conn == NULL)
+    {
+        perror("Connection allocation failed");
+        exit(1);
+    }
+    conn->w.kind = W_CONN;
+    conn->w.conn = conn;
+    conn->next = conns;
+    conns = conn;
+    ioAdd(&conn->w.io, (int)res, 0);
+    ioRead(&conn->w.io);
+}
+
+
+// *****************************************************************************
+//
+// static void ioDone(struct IoWatch *io, int op, ssize_t res, char *data)
+//
+// Purpose: I/O completion callback: hands each completion to the code for
+//          the descriptor it happened on.
+//
+// *****************************************************************************
+//
+static void ioDone(struct IoWatch *io, int op, ssize_t res, char *data)
+{
+    struct Watch *w = (struct Watch *) io;
+    struct signalfd_siginfo si;
+    ssize_t i;
+
+    switch(w->kind)
+    {
+        case W_LISTEN:
+            acceptConn(res);
+            break;
+        case W_SIGNAL:
+            for(i = 0; i + (ssize_t)sizeof(si) <= res; i += sizeof(si))
+            {
+                memcpy(&si, data + i, sizeof(si));
+                if(si.ssi_signo != SIGCHLD)
+                {
+                    running = 0;
+                }
+            }
+            reapRequests();
+            ioRead(io);
+            break;
+        case W_CONN:
+            if(op == IO_WRITE)
+            {
+                connWritten(w->conn, res);
+            }
+            else
+            {
+                readConn(w->conn, res, data);
+            }
+            freeConnIfDone(w->conn);
+            break;
+        case W_STDIN:
+            writeInput(w, res);
+            break;
+        case W_STDOUT:
+        case W_STDERR:
+            readOutput(w, res, data);
+            break;
+    }
+}
+
+
+// *****************************************************************************
+//
+// static int listenOn(const char *path)
+//
+// Purpose: Creates the listening socket at path.
+//
+// *****************************************************************************
+//
+static int listenOn(const char *path)
+{
+    struct sockaddr_un addr;  // Socket address
+    struct stat st;           // What is already at path, if anything
+    int fd;
+
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "smallsh: %s: socket path too long\n", path);
+        return -1;
+    }
+
+    // Only remove a leftover socket, never some other file.
+    //
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        unlink(path);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        perror("Server socket");
+        return -1;
+    }
+    if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+       listen(fd, SOMAXCONN) == -1)
+    {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+// *****************************************************************************
+//
+// int runServer(const char *path)
+//
+// Purpose: Serves command requests on path until SIGINT or SIGTERM.
+//
+// *****************************************************************************
+//
+int runServer(const char *path)
+{
+    struct Conn *conn;
+    struct Request *req;
+    sigset_t mask;                          // Signals taken via signalfd
+    int sigFd;
+    int listenFd;
+
+    // Writing to a program that quit reading, or a client that went away,
+    // must not kill the server.
+    //
+    signal(SIGPIPE, SIG_IGN);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, &savedMask);
+
+    if(ioInit() == NULL)
+    {
+        return 1;
+    }
+    sigFd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if(sigFd < 0)
+    {
+        perror("signalfd()");
+        return 1;
+    }
+    listenFd = listenOn(path);
+    if(listenFd < 0)
+    {
+        return 1;
+    }
+    ioAdd(&signalW.io, sigFd, 0);
+    ioAdd(&listenW.io, listenFd, 1);
+    ioRead(&signalW.io);
+    ioRead(&listenW.io);
+    traceEnd("server listening");
+
+    running = 1;
+    while(running)
+    {
+        if(ioWait(ioDone) == -1)
+        {
+            break;
+        }
+        freeDead();
+    }
+
+    // Shutting down: stop whatever is still running.
+    //
+    for(conn = conns; conn != NULL; conn = conn->next)
+    {
+        for(req = conn->reqs; req != NULL; req = req->next)
+        {
+            if(req->running && !req->exited)
+            {
+                kill(req->pid, SIGTERM);
+            }
+        }
+    }
+    unlink(path);
+    sigprocmask(SIG_SETMASK, &savedMask, NULL);
+
+    return 0;
+}
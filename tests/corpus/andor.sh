@@ -0,0 +1,4 @@
+true && echo yes || echo no
+false ||
+  echo continued &&
+  echo here
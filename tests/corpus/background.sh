@@ -0,0 +1,3 @@
+sleep 10 &
+echo started & echo again &
+jobs
@@ -0,0 +1,4 @@
+cd
+cd ..
+status
+exit 3
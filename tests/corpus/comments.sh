@@ -0,0 +1,3 @@
+# comment only
+echo a # trailing comment
+{ echo grouped; echo twice; } > out
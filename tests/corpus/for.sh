@@ -0,0 +1,7 @@
+for i in 1 2 3; do
+    for j in a b; do echo $i$j; done
+done
+for arg
+do
+    echo $arg
+done
@@ -0,0 +1,6 @@
+greet() {
+    echo hello $1
+    return 0
+}
+greet world
+count() for x in $@; do echo $x; done
@@ -0,0 +1,7 @@
+if test -f x; then
+    echo file
+elif test -d x; then
+    echo dir
+else
+    echo none
+fi
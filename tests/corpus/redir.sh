@@ -0,0 +1,3 @@
+sort < in.txt > out.txt
+< in cat
+> empty
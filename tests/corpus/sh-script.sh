@@ -0,0 +1,114 @@
+#!/bin/sh
+#
+# *****************************************************************************
+#
+# Project:   smallsh
+# Filename:  bench/loops.sh
+#
+#
+# Overview:
+#    Times loop-heavy scripts run by smallsh's own script engine against the
+#    same loops handed to an external shell, which is what a smallsh user
+#    had to do before smallsh had loops.
+#
+#    Usage: bench/loops.sh [smallsh binary] [external shell] [runs]
+#
+#    Each case is run 'runs' times (default 5) and the fastest wall-clock
+#    time is printed, in milliseconds:
+#
+#       smallsh   smallsh runs the script itself
+#       via-sh    smallsh runs one command, 'sh script', that runs the loop
+#       sh        the external shell runs the script directly (reference)
+#
+# *****************************************************************************
+#
+
+SMALLSH=${1:-./smallsh}
+EXTSH=${2:-/bin/sh}
+RUNS=${3:-5}
+
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+# Writes the word list 1..$1 on one line.
+#
+seqWords()
+{
+    i=1
+    out=""
+    while [ $i -le "$1" ]; do
+        out="$out $i"
+        i=$((i + 1))
+    done
+    echo $out
+}
+
+W100=$(seqWords 100)
+W20=$(seqWords 20)
+
+# builtins: 10000 iterations of nested loops, tests and variable updates,
+# with no programs started.
+#
+cat > "$DIR/builtins.sh" <<SCRIPT
+for i in $W100; do
+    for j in $W100; do
+        if false; then
+            x=\$i
+        elif true; then
+            x=\$j
+        fi
+    done
+done
+SCRIPT
+
+# functions: 4000 function calls with arguments and return codes.
+#
+cat > "$DIR/functions.sh" <<SCRIPT
+f() { if true; then return 0; fi; }
+g() { f \$1 \$2 && f \$2 || false; }
+for i in $W20; do
+    for j in $W100; do
+        g \$i \$j
+        g \$j \$i
+    done
+done
+SCRIPT
+
+# programs: 400 iterations that each start a program, so the cost of the
+# loop itself is mostly hidden behind fork and exec.
+#
+cat > "$DIR/programs.sh" <<SCRIPT
+for i in $W20; do
+    for j in $W20; do
+        /bin/true \$i \$j
+    done
+done
+SCRIPT
+
+# Prints the fastest of $RUNS runs of the given command, in milliseconds.
+#
+best()
+{
+    min=""
+    n=0
+    while [ $n -lt "$RUNS" ]; do
+        t0=$(date +%s%N)
+        "$@" > /dev/null 2>&1 < /dev/null
+        t1=$(date +%s%N)
+        t=$(( (t1 - t0) / 1000 ))
+        if [ -z "$min" ] || [ $t -lt $min ]; then
+            min=$t
+        fi
+        n=$((n + 1))
+    done
+    printf '%8d.%03d' $((min / 1000)) $((min % 1000))
+}
+
+printf '%-10s %12s %12s %12s\n' script smallsh via-sh sh
+for s in builtins functions programs; do
+    echo "$EXTSH $DIR/$s.sh" > "$DIR/$s.via"
+    printf '%-10s %12s %12s %12s\n' $s \
+        "$(best "$SMALLSH" "$DIR/$s.sh")" \
+        "$(best "$SMALLSH" "$DIR/$s.via")" \
+        "$(best "$EXTSH" "$DIR/$s.sh")"
+done
@@ -0,0 +1,2 @@
+if true; then
+  while true; do
@@ -0,0 +1,3 @@
+n=0
+while test $n != 3; do n=x$n; break; done
+until false; do continue; done
@@ -0,0 +1,368 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  tests/fuzz_parse.c
+//
+//
+// Overview:
+//    Fuzz target for the script parser. Every input is parsed and checked
+//    with checkParse() (see parse_check.h); a failed check aborts, so the
+//    fuzzer (and the sanitizers it is built with) report it like a crash.
+//
+//    Built with -DSMALLSH_LIBFUZZER and clang -fsanitize=fuzzer it is a
+//    libFuzzer target. Otherwise it has its own main():
+//
+//       fuzz_parse [file...]
+//          Check each file, or stdin if there are none. This is what AFL
+//          runs ('afl-fuzz -i tests/corpus -o out -- tests/fuzz_parse @@'),
+//          and how the corpus is replayed by 'make check'.
+//
+//       fuzz_parse -n runs [-s seed] file...
+//          Small built-in mutational fuzzer for machines without libFuzzer
+//          or AFL: checks the files, then 'runs' inputs made by mutating
+//          and splicing them with the tokens in fuzz.dict.
+//
+//       fuzz_parse -b rounds file...
+//          Parser benchmark: parses every file 'rounds' times (without the
+//          checks) and reports the throughput.
+//
+//    A failing input is written to fuzz_parse.fail before aborting.
+//
+// *****************************************************************************
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "parse_check.h"
+
+
+// *****************************************************************************
+//
+// int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+//
+// Purpose: Checks one input; aborts if a check fails.
+//
+// *****************************************************************************
+//
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const char *why;
+    FILE *out;
+
+    why = checkParse((const char *)data, size);
+    if(why != NULL)
+    {
+        fprintf(stderr, "fuzz_parse: %s (input saved in fuzz_parse.fail)\n", why);
+        out = fopen("fuzz_parse.fail", "wb");
+        if(out != NULL)
+        {
+            fwrite(data, 1, size, out);
+            fclose(out);
+        }
+        abort();
+    }
+
+    return 0;
+}
+
+
+#ifndef SMALLSH_LIBFUZZER
+
+
+#define MAX_INPUT 65536         // Largest input the mutator makes
+
+
+// Tokens the mutator splices in (the same ones as fuzz.dict).
+//
+static const char *tokens[] = {
+    "if ", "then ", "elif ", "else ", "fi", "while ", "until ", "do ", "done",
+    "for ", " in ", "{ ", " }", "()", "f() ", "&&", "||", "|", "&", ";", "\n",
+    "<", ">", " < f", " > f", "#", "$", "${", "}", "$?", "$@", " ", "\t",
+    "\r", "x", "echo ", "cd", "exit", "break", "return", "true", "false",
+    "=", "a=b ", "(", ")", "\0",
+};
+
+
+// struct Input: One input file (or generated input)
+//
+struct Input {
+    char *data;
+    size_t len;
+};
+
+
+static uint64_t rngState = 0x9e3779b97f4a7c15ull;
+
+
+// *****************************************************************************
+//
+// static uint64_t rnd(uint64_t n)
+//
+// Purpose: Returns a pseudo-random number below n (xorshift64*).
+//
+// *****************************************************************************
+//
+static uint64_t rnd(uint64_t n)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+
+    return n == 0 ? 0 : (rngState * 0x2545f4914f6cdd1dull) % n;
+}
+
+
+// *****************************************************************************
+//
+// static int readInput(FILE *in, struct Input *input)
+//
+// Purpose: Reads a whole stream into memory. Returns -1 on error.
+//
+// *****************************************************************************
+//
+static int readInput(FILE *in, struct Input *input)
+{
+    size_t cap = 4096;
+    size_t n;
+
+    input->data = (char *) malloc(cap);
+    input->len = 0;
+    while(input->data != NULL &&
+          (n = fread(input->data + input->len, 1, cap - input->len, in)) > 0)
+    {
+        input->len += n;
+        if(input->len == cap)
+        {
+            cap *= 2;
+            input->data = (char *) realloc(input->data, cap);
+        }
+    }
+
+    return input->data == NULL || ferror(in) ? -1 : 0;
+}
+
+
+// *****************************************************************************
+//
+// static void replace(char *buf, size_t *len, size_t at, size_t cut,
+//                     const char *add, size_t addLen)
+//
+// Purpose: Replaces cut bytes of buf at offset at with add, as far as
+//          MAX_INPUT allows.
+//
+// *****************************************************************************
+//
+static void replace(char *buf, size_t *len, size_t at, size_t cut,
+                    const char *add, size_t addLen)
+{
+    if(*len - cut + addLen > MAX_INPUT)
+    {
+        addLen = MAX_INPUT - (*len - cut);
+    }
+    memmove(buf + at + addLen, buf + at + cut, *len - at - cut);
+    memcpy(buf + at, add, addLen);
+    *len = *len - cut + addLen;
+}
+
+
+// *****************************************************************************
+//
+// static void mutate(char *buf, size_t *len, struct Input *inputs, int numInputs)
+//
+// Purpose: Applies a few random edits to buf: inserting or overwriting with
+//          a token, deleting, duplicating or flipping bytes, and splicing in
+//          part of another input.
+//
+// *****************************************************************************
+//
+static void mutate(char *buf, size_t *len, struct Input *inputs, int numInputs)
+{
+    const char *tok;
+    struct Input *other;
+    char copy[256];
+    size_t at;
+    size_t n;
+    int edits = 1 + (int)rnd(4);
+
+    while(edits-- > 0)
+    {
+        at = rnd(*len + 1);
+        switch(rnd(6))
+        {
+            case 0:                         // insert a token
+            case 1:                         // overwrite with a token
+                tok = tokens[rnd(sizeof(tokens) / sizeof(tokens[0]))];
+                n = tok[0] == '\0' ? 1 : strlen(tok);
+                replace(buf, len, at, rnd(2) && at + n <= *len ? n : 0, tok, n);
+                break;
+            case 2:                         // delete a range
+                n = rnd(*len - at + 1);
+                replace(buf, len, at, n > 16 ? rnd(16) : n, "", 0);
+                break;
+            case 3:                         // duplicate a range
+                n = rnd(*len - at + 1);
+                n = n > sizeof(copy) ? sizeof(copy) : n;
+                memcpy(copy, buf + at, n);
+                replace(buf, len, at, 0, copy, n);
+                break;
+            case 4:                         // flip a byte
+                if(at < *len)
+                {
+                    buf[at] ^= (char)(1 << rnd(8));
+                }
+                break;
+            default:                        // splice in part of another input
+                other = &inputs[rnd(numInputs)];
+                n = rnd(other->len + 1);
+                n = n > sizeof(copy) ? sizeof(copy) : n;
+                memcpy(copy, other->data + rnd(other->len - n + 1), n);
+                replace(buf, len, at, 0, copy, n);
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static double seconds(void)
+//
+// Purpose: Returns CLOCK_MONOTONIC time in seconds.
+//
+// *****************************************************************************
+//
+static double seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct Input *inputs;       // Files named on the command line
+    int numInputs;
+    long runs = 0;              // Mutated inputs to try (-n)
+    long rounds = 0;            // Benchmark rounds (-b)
+    char *buf;                  // Input being mutated
+    size_t len;
+    struct Arena arena;
+    struct AstNode *tree;
+    char errMsg[128];
+    size_t bytes = 0;
+    double start;
+    double elapsed;
+    FILE *in;
+    long i;
+    int opt;
+    int j;
+
+    while((opt = getopt(argc, argv, "n:s:b:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                runs = atol(optarg);
+                break;
+            case 's':
+                rngState = strtoull(optarg, NULL, 0) | 1;
+                break;
+            case 'b':
+                rounds = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n runs [-s seed] | -b rounds] [file...]\n", argv[0]);
+                exit(2);
+        }
+    }
+
+    // Load every input up front (stdin if no files are named).
+    //
+    numInputs = optind < argc ? argc - optind : 1;
+    inputs = (struct Input *) calloc(numInputs, sizeof(struct Input));
+    for(j = 0; inputs != NULL && j < numInputs; j++)
+    {
+        in = optind < argc ? fopen(argv[optind + j], "rb") : stdin;
+        if(in == NULL || readInput(in, &inputs[j]) == -1)
+        {
+            perror(optind < argc ? argv[optind + j] : "stdin");
+            exit(1);
+        }
+        if(in != stdin)
+        {
+            fclose(in);
+        }
+    }
+    if(inputs == NULL)
+    {
+        perror("calloc()");
+        exit(1);
+    }
+
+    if(rounds > 0)
+    {
+        arenaInit(&arena);
+        start = seconds();
+        for(i = 0; i < rounds; i++)
+        {
+            for(j = 0; j < numInputs; j++)
+            {
+                parseScript(inputs[j].data, inputs[j].len, &arena, &tree, errMsg, sizeof(errMsg));
+                arenaReset(&arena);
+                bytes += inputs[j].len;
+            }
+        }
+        elapsed = seconds() - start;
+        arenaFree(&arena);
+        printf("parsed %ld inputs, %zu bytes in %.3f s: %.1f MB/s, %.2f us per input\n",
+               rounds * numInputs, bytes, elapsed, bytes / elapsed / 1e6,
+               elapsed * 1e6 / (rounds * numInputs));
+        return 0;
+    }
+
+    for(j = 0; j < numInputs; j++)
+    {
+        LLVMFuzzerTestOneInput((const uint8_t *)inputs[j].data, inputs[j].len);
+    }
+
+    buf = (char *) malloc(MAX_INPUT);
+    if(buf == NULL)
+    {
+        perror("malloc()");
+        exit(1);
+    }
+    for(i = 0; i < runs; i++)
+    {
+        j = (int)rnd(numInputs);
+        len = inputs[j].len > MAX_INPUT ? MAX_INPUT : inputs[j].len;
+        memcpy(buf, inputs[j].data, len);
+        mutate(buf, &len, inputs, numInputs);
+        LLVMFuzzerTestOneInput((const uint8_t *)buf, len);
+    }
+    if(runs > 0)
+    {
+        printf("fuzz_parse: %ld inputs checked\n", runs + numInputs);
+    }
+
+    free(buf);
+    for(j = 0; j < numInputs; j++)
+    {
+        free(inputs[j].data);
+    }
+    free(inputs);
+
+    return 0;
+}
+
+
+#endif
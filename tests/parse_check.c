@@ -0,0 +1,536 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  tests/parse_check.c
+//
+//
+// Overview:
+//    Checks shared by the parser fuzz target and the property tests (see
+//    parse_check.h).
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // open_memstream()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parse_check.h"
+
+
+#define MAX_TREE_DEPTH (2 * MAX_NEST + MAX_ARGS)  // Deepest tree allowed
+
+
+static void printList(FILE *out, struct AstNode *list);
+
+
+// *****************************************************************************
+//
+// static void printNode(FILE *out, struct AstNode *node)
+//
+// Purpose: Prints one node (and everything below it).
+//
+// *****************************************************************************
+//
+static void printNode(FILE *out, struct AstNode *node)
+{
+    int i;
+
+    switch(node->type)
+    {
+        case N_CMD:
+            fprintf(out, "(cmd");
+            for(i = 0; i < node->numWords; i++)
+            {
+                fprintf(out, " %s", node->words[i]);
+            }
+            if(node->redirIn != NULL)
+            {
+                fprintf(out, " <%s", node->redirIn);
+            }
+            if(node->redirOut != NULL)
+            {
+                fprintf(out, " >%s", node->redirOut);
+            }
+            if(node->bg)
+            {
+                fprintf(out, " &");
+            }
+            fprintf(out, ")");
+            break;
+        case N_AND:
+        case N_OR:
+            fprintf(out, node->type == N_AND ? "(and " : "(or ");
+            printNode(out, node->left);
+            fprintf(out, " ");
+            printNode(out, node->right);
+            fprintf(out, ")");
+            break;
+        case N_IF:
+            fprintf(out, "(if ");
+            printList(out, node->cond);
+            fprintf(out, " ");
+            printList(out, node->body);
+            if(node->elseBody != NULL)
+            {
+                fprintf(out, " ");
+                printList(out, node->elseBody);
+            }
+            fprintf(out, ")");
+            break;
+        case N_WHILE:
+        case N_UNTIL:
+            fprintf(out, node->type == N_WHILE ? "(while " : "(until ");
+            printList(out, node->cond);
+            fprintf(out, " ");
+            printList(out, node->body);
+            fprintf(out, ")");
+            break;
+        case N_FOR:
+            fprintf(out, "(for %s", node->name);
+            if(node->hasIn)
+            {
+                fprintf(out, " in");
+                for(i = 0; i < node->numWords; i++)
+                {
+                    fprintf(out, " %s", node->words[i]);
+                }
+                fprintf(out, " ;");
+            }
+            fprintf(out, " ");
+            printList(out, node->body);
+            fprintf(out, ")");
+            break;
+        case N_GROUP:
+            fprintf(out, "({ ");
+            printList(out, node->body);
+            fprintf(out, ")");
+            break;
+        case N_FUNCDEF:
+            fprintf(out, "(def %s ", node->name);
+            printNode(out, node->body);
+            fprintf(out, ")");
+            break;
+        default:
+            fprintf(out, "(?%d)", node->type);
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void printList(FILE *out, struct AstNode *list)
+//
+// Purpose: Prints a command list as [node node ...].
+//
+// *****************************************************************************
+//
+static void printList(FILE *out, struct AstNode *list)
+{
+    fprintf(out, "[");
+    for(; list != NULL; list = list->next)
+    {
+        printNode(out, list);
+        if(list->next != NULL)
+        {
+            fprintf(out, " ");
+        }
+    }
+    fprintf(out, "]");
+}
+
+
+// *****************************************************************************
+//
+// char *treeString(struct AstNode *tree)
+//
+// Purpose: Prints a syntax tree into a string.
+//
+// *****************************************************************************
+//
+char *treeString(struct AstNode *tree)
+{
+    char *str = NULL;
+    size_t len = 0;
+    FILE *out;
+
+    out = open_memstream(&str, &len);
+    if(out == NULL)
+    {
+        perror("open_memstream()");
+        exit(1);
+    }
+    printList(out, tree);
+    fclose(out);
+
+    return str;
+}
+
+
+// *****************************************************************************
+//
+// static int goodWord(const char *word)
+//
+// Purpose: Tells whether a string could have come out of the tokenizer as a
+//          word: not empty, no blanks or operator characters, no "||", and
+//          not the start of a comment.
+//
+// *****************************************************************************
+//
+static int goodWord(const char *word)
+{
+    return word != NULL && word[0] != '\0' && word[0] != '#' &&
+           strpbrk(word, " \t\r\n;&<>()") == NULL && strstr(word, "||") == NULL;
+}
+
+
+// *****************************************************************************
+//
+// static int goodName(const char *name)
+//
+// Purpose: Tells whether a string is a valid variable or function name.
+//
+// *****************************************************************************
+//
+static int goodName(const char *name)
+{
+    size_t i;
+
+    if(name == NULL || name[0] == '\0' || (name[0] >= '0' && name[0] <= '9'))
+    {
+        return 0;
+    }
+    for(i = 0; name[i] != '\0'; i++)
+    {
+        if(!(name[i] == '_' || (name[i] >= 'a' && name[i] <= 'z') ||
+             (name[i] >= 'A' && name[i] <= 'Z') || (name[i] >= '0' && name[i] <= '9')))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+// *****************************************************************************
+//
+// static int goodWords(char **words, int numWords)
+//
+// Purpose: Tells whether a word list is properly terminated and holds only
+//          good words.
+//
+// *****************************************************************************
+//
+static int goodWords(char **words, int numWords)
+{
+    int i;
+
+    if(words == NULL || numWords < 0 || numWords >= MAX_ARGS || words[numWords] != NULL)
+    {
+        return 0;
+    }
+    for(i = 0; i < numWords; i++)
+    {
+        if(!goodWord(words[i]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+static const char *checkList(struct AstNode *list, const char *src, size_t len, int depth);
+
+
+// *****************************************************************************
+//
+// static const char *checkNode(struct AstNode *node, const char *src,
+//                              size_t len, int depth)
+//
+// Purpose: Checks one node and everything below it. src and len are the
+//          parsed text, which a function body's source must lie within.
+//
+// *****************************************************************************
+//
+static const char *checkNode(struct AstNode *node, const char *src, size_t len, int depth)
+{
+    struct Arena arena;
+    struct AstNode *tree;
+    const char *why = NULL;
+    char errMsg[128];
+    char *want;
+    char *got;
+    int result;
+
+    if(node == NULL)
+    {
+        return "missing node";
+    }
+    if(depth > MAX_TREE_DEPTH)
+    {
+        return "tree nested deeper than the parser allows";
+    }
+    if(node->bg && node->type != N_CMD)
+    {
+        return "'&' on a compound command";
+    }
+
+    switch(node->type)
+    {
+        case N_CMD:
+            if(!goodWords(node->words, node->numWords))
+            {
+                return "bad simple command word list";
+            }
+            if((node->redirIn != NULL && !goodWord(node->redirIn)) ||
+               (node->redirOut != NULL && !goodWord(node->redirOut)))
+            {
+                return "bad redirection file name";
+            }
+            if(node->numWords == 0 && node->redirIn == NULL && node->redirOut == NULL)
+            {
+                return "empty simple command";
+            }
+            return NULL;
+        case N_AND:
+        case N_OR:
+            if(node->left == NULL || node->right == NULL ||
+               node->left->next != NULL || node->right->next != NULL)
+            {
+                return "bad && / || operands";
+            }
+            if(node->right->type == N_AND || node->right->type == N_OR)
+            {
+                return "&& / || grouped to the right";
+            }
+            why = checkNode(node->left, src, len, depth + 1);
+            return why != NULL ? why : checkNode(node->right, src, len, depth + 1);
+        case N_IF:
+            if(node->cond == NULL || node->body == NULL)
+            {
+                return "if without a condition or body";
+            }
+            why = checkList(node->cond, src, len, depth + 1);
+            if(why == NULL)
+            {
+                why = checkList(node->body, src, len, depth + 1);
+            }
+            if(why == NULL && node->elseBody != NULL)
+            {
+                why = checkList(node->elseBody, src, len, depth + 1);
+            }
+            return why;
+        case N_WHILE:
+        case N_UNTIL:
+            if(node->cond == NULL || node->body == NULL)
+            {
+                return "loop without a condition or body";
+            }
+            why = checkList(node->cond, src, len, depth + 1);
+            return why != NULL ? why : checkList(node->body, src, len, depth + 1);
+        case N_FOR:
+            if(!goodName(node->name) || !goodWords(node->words, node->numWords) ||
+               (!node->hasIn && node->numWords != 0))
+            {
+                return "bad for loop variable or word list";
+            }
+            if(node->body == NULL)
+            {
+                return "for loop without a body";
+            }
+            return checkList(node->body, src, len, depth + 1);
+        case N_GROUP:
+            if(node->body == NULL)
+            {
+                return "empty { } group";
+            }
+            return checkList(node->body, src, len, depth + 1);
+        case N_FUNCDEF:
+            if(!goodName(node->name))
+            {
+                return "bad function name";
+            }
+            if(node->body == NULL || node->body->next != NULL ||
+               node->body->type == N_CMD || node->body->type == N_AND ||
+               node->body->type == N_OR || node->body->type == N_FUNCDEF)
+            {
+                return "function body is not one compound command";
+            }
+            if(node->src < src || node->srcLen == 0 || node->src + node->srcLen > src + len)
+            {
+                return "function source outside the parsed text";
+            }
+            why = checkNode(node->body, src, len, depth + 1);
+            if(why != NULL)
+            {
+                return why;
+            }
+
+            // The evaluator reparses the saved body text when the function
+            // is defined and counts on getting the same tree back.
+            //
+            arenaInit(&arena);
+            result = parseScript(node->src, node->srcLen, &arena, &tree, errMsg, sizeof(errMsg));
+            if(result != PARSE_OK || tree == NULL || tree->next != NULL)
+            {
+                why = "function source does not parse on its own";
+            }
+            else
+            {
+                want = treeString(node->body);
+                got = treeString(tree);
+                if(strcmp(got, want) != 0)
+                {
+                    why = "function source parses to a different tree";
+                }
+                free(want);
+                free(got);
+            }
+            arenaFree(&arena);
+            return why;
+        default:
+            return "unknown node type";
+    }
+}
+
+
+// *****************************************************************************
+//
+// static const char *checkList(struct AstNode *list, const char *src,
+//                              size_t len, int depth)
+//
+// Purpose: Checks every command in a list.
+//
+// *****************************************************************************
+//
+static const char *checkList(struct AstNode *list, const char *src, size_t len, int depth)
+{
+    const char *why;
+    int count = 0;
+
+    for(; list != NULL; list = list->next)
+    {
+        if(++count > (int)len + 1)
+        {
+            return "command list longer than the input (a loop?)";
+        }
+        why = checkNode(list, src, len, depth);
+        if(why != NULL)
+        {
+            return why;
+        }
+    }
+
+    return NULL;
+}
+
+
+// *****************************************************************************
+//
+// const char *checkParse(const char *src, size_t len)
+//
+// Purpose: Parses arbitrary input and checks everything parseScript()
+//          promises about the result.
+//
+// *****************************************************************************
+//
+const char *checkParse(const char *src, size_t len)
+{
+    struct Arena arena;
+    struct AstNode *tree;
+    struct AstNode *again;
+    const char *why = NULL;
+    char errMsg[128];
+    char *first = NULL;
+    char *second = NULL;
+    char *padded;
+    int result;
+
+    arenaInit(&arena);
+    memset(errMsg, 'x', sizeof(errMsg));
+    result = parseScript(src, len, &arena, &tree, errMsg, sizeof(errMsg));
+
+    if(result != PARSE_OK && result != PARSE_ERROR && result != PARSE_INCOMPLETE)
+    {
+        why = "unknown parse result";
+    }
+    else if(memchr(errMsg, '\0', sizeof(errMsg)) == NULL)
+    {
+        why = "error message not terminated";
+    }
+    else if(result != PARSE_OK && (tree != NULL || errMsg[0] == '\0'))
+    {
+        why = "failed parse left a tree or no message";
+    }
+    else if(result == PARSE_OK && errMsg[0] != '\0')
+    {
+        why = "successful parse left an error message";
+    }
+    else if(result == PARSE_OK)
+    {
+        why = checkList(tree, src, len, 0);
+    }
+    if(why != NULL || result != PARSE_OK)
+    {
+        arenaFree(&arena);
+        return why;
+    }
+
+    // Same input, same tree.
+    //
+    first = treeString(tree);
+    if(parseScript(src, len, &arena, &again, errMsg, sizeof(errMsg)) != PARSE_OK)
+    {
+        why = "second parse of the same input failed";
+    }
+    else
+    {
+        second = treeString(again);
+        if(strcmp(first, second) != 0)
+        {
+            why = "second parse of the same input gave a different tree";
+        }
+        free(second);
+    }
+
+    // A complete statement stays complete (and the same) when the line it
+    // is on is ended; the shell relies on this to run each statement as
+    // soon as it has been typed.
+    //
+    padded = (char *) malloc(len + 1);
+    if(padded == NULL)
+    {
+        perror("malloc()");
+        exit(1);
+    }
+    memcpy(padded, src, len);
+    padded[len] = '\n';
+    if(why == NULL &&
+       parseScript(padded, len + 1, &arena, &again, errMsg, sizeof(errMsg)) != PARSE_OK)
+    {
+        why = "complete statement fails to parse with a newline added";
+    }
+    else if(why == NULL)
+    {
+        second = treeString(again);
+        if(strcmp(first, second) != 0)
+        {
+            why = "adding a newline changed the tree";
+        }
+        free(second);
+    }
+
+    free(padded);
+    free(first);
+    arenaFree(&arena);
+
+    return why;
+}
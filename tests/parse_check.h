@@ -0,0 +1,72 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  tests/parse_check.h
+//
+//
+// Overview:
+//    Checks shared by the parser fuzz target and the property tests: a
+//    printable form of a syntax tree, and the promises parseScript() makes
+//    about its result whatever the input.
+//
+// *****************************************************************************
+//
+
+
+#ifndef PARSE_CHECK_H
+#define PARSE_CHECK_H
+
+
+#include <stddef.h>
+#include "../smallsh.h"
+
+
+// *****************************************************************************
+//
+// char *treeString(struct AstNode *tree)
+//
+//    Entry:   struct AstNode *tree
+//                Command list returned by parseScript() (may be NULL).
+//
+//    Exit:    Returns a malloc()'d string the caller frees.
+//
+//    Purpose: Print a syntax tree as nested lists, for instance
+//             "[(and (cmd a <in) (cmd b &))]", so two trees can be compared
+//             as strings.
+//
+// *****************************************************************************
+//
+char *treeString(struct AstNode *tree);
+
+
+// *****************************************************************************
+//
+// const char *checkParse(const char *src, size_t len)
+//
+//    Entry:   const char *src, size_t len
+//                Any bytes at all.
+//
+//    Exit:    Returns NULL if every check passed, or a description of the
+//             first one that failed.
+//
+//    Purpose: Parse the input and check the result:
+//
+//             - the result is PARSE_OK, PARSE_ERROR or PARSE_INCOMPLETE, with
+//               a tree only for PARSE_OK and a message only otherwise
+//             - every node is well formed (operands present, word lists
+//               terminated, words non-empty and free of operator characters,
+//               '&' only on simple commands, names valid, nesting bounded)
+//             - a function body's saved source parses on its own to the
+//               same tree
+//             - parsing the same input again gives the same tree
+//             - a complete statement is still complete with a newline added
+//
+// *****************************************************************************
+//
+const char *checkParse(const char *src, size_t len);
+
+
+#endif
@@ -0,0 +1,852 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  tests/parse_props.c
+//
+//
+// Overview:
+//    Property tests for the script parser.
+//
+//    Random syntax trees are generated and written out as script text in
+//    randomly chosen but equivalent ways: blanks or none around operators,
+//    ';' or newlines between commands, comments, "elif" or a nested "if"
+//    under "else", redirections among the words. For every script:
+//
+//       - it parses, to exactly the tree it was written from
+//       - every prefix ending in a newline parses as complete or
+//         incomplete, never as an error (the shell asks for more input
+//         until a statement is finished)
+//       - it and random truncations of it pass checkParse()
+//
+//    A table of hand-written inputs (the malformed lines the parser once
+//    let through among them) checks the result for each.
+//
+//    Usage: parse_props [-n cases] [-s seed]
+//
+// *****************************************************************************
+//
+
+
+#define _GNU_SOURCE             // open_memstream()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "parse_check.h"
+
+
+#define GEN_DEPTH 4             // Deepest nesting of generated compounds
+
+
+// Words a command may start with, and further words (which may be reserved
+// words: only the first word of a command is looked at).
+//
+static const char *firstWords[] = {
+    "echo", "true", "false", "x", "cmd2", "-n", "$v", "${HOME}", "a|b",
+    "a=b", "%", "@", "1", "/bin/ls", "./run.sh", "in", "esac", "a}", "{a",
+};
+static const char *moreWords[] = {
+    "echo", "x", "-l", "$1", "$@", "$?", "a|b", "file.txt", "if", "then",
+    "else", "fi", "do", "done", "for", "{", "}", "in", "while", "a#b",
+};
+static const char *names[] = {
+    "f", "g", "_x", "loop2", "A_B", "i",
+};
+
+static uint64_t rngState = 0x2545f4914f6cdd1dull;
+static struct Arena genArena;   // Holds the generated trees
+
+
+// *****************************************************************************
+//
+// static uint64_t rnd(uint64_t n)
+//
+// Purpose: Returns a pseudo-random number below n (xorshift64*).
+//
+// *****************************************************************************
+//
+static uint64_t rnd(uint64_t n)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+
+    return n == 0 ? 0 : (rngState * 0x2545f4914f6cdd1dull) % n;
+}
+
+#define PICK(list) ((char *)(list)[rnd(sizeof(list) / sizeof((list)[0]))])
+
+
+static struct AstNode *genList(int depth);
+
+
+// *****************************************************************************
+//
+// static struct AstNode *genNode(int type)
+//
+// Purpose: Allocates a zeroed node for a generated tree.
+//
+// *****************************************************************************
+//
+static struct AstNode *genNode(int type)
+{
+    struct AstNode *node;
+
+    node = (struct AstNode *) arenaAlloc(&genArena, sizeof(struct AstNode));
+    node->type = type;
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static char **genWords(const char *first, int numWords)
+//
+// Purpose: Makes a NULL-terminated word list: first (if not NULL) followed
+//          by random further words.
+//
+// *****************************************************************************
+//
+static char **genWords(const char *first, int numWords)
+{
+    char **words;
+    int i;
+
+    words = (char **) arenaAlloc(&genArena, (numWords + 1) * sizeof(char *));
+    for(i = 0; i < numWords; i++)
+    {
+        words[i] = (i == 0 && first != NULL) ? (char *)first : PICK(moreWords);
+    }
+
+    return words;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *genSimple(void)
+//
+// Purpose: Generates a simple command: words, redirections, or both.
+//
+// *****************************************************************************
+//
+static struct AstNode *genSimple(void)
+{
+    struct AstNode *node = genNode(N_CMD);
+
+    node->numWords = (int)rnd(4);
+    node->words = genWords(PICK(firstWords), node->numWords);
+    if(node->numWords == 0 || rnd(4) == 0)
+    {
+        node->redirIn = rnd(2) ? PICK(moreWords) : NULL;
+        node->redirOut = (node->redirIn == NULL || rnd(2)) ? PICK(moreWords) : NULL;
+    }
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *genIf(int depth)
+//
+// Purpose: Generates an if command, maybe with an else part or with another
+//          if as its else part (which is what "elif" parses to).
+//
+// *****************************************************************************
+//
+static struct AstNode *genIf(int depth)
+{
+    struct AstNode *node = genNode(N_IF);
+
+    node->cond = genList(depth + 1);
+    node->body = genList(depth + 1);
+    switch(rnd(3))
+    {
+        case 0:
+            node->elseBody = genList(depth + 1);
+            break;
+        case 1:
+            if(depth + 1 < GEN_DEPTH)
+            {
+                node->elseBody = genIf(depth + 1);
+            }
+            break;
+    }
+
+    return node;
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *genCommand(int depth)
+//
+// Purpose: Generates one command: mostly simple ones, compound ones while
+//          the nesting allows.
+//
+// *****************************************************************************
+//
+static struct AstNode *genCommand(int depth)
+{
+    struct AstNode *node;
+
+    if(depth >= GEN_DEPTH || rnd(4) != 0)
+    {
+        return genSimple();
+    }
+
+    switch(rnd(5))
+    {
+        case 0:
+            return genIf(depth);
+        case 1:
+            node = genNode(rnd(2) ? N_WHILE : N_UNTIL);
+            node->cond = genList(depth + 1);
+            node->body = genList(depth + 1);
+            return node;
+        case 2:
+            node = genNode(N_FOR);
+            node->name = PICK(names);
+            node->hasIn = (char)rnd(2);
+            node->numWords = node->hasIn ? (int)rnd(4) : 0;
+            node->words = genWords(NULL, node->numWords);
+            node->body = genList(depth + 1);
+            return node;
+        default:
+            node = genNode(N_GROUP);
+            node->body = genList(depth + 1);
+            return node;
+    }
+}
+
+
+// *****************************************************************************
+//
+// static struct AstNode *genList(int depth)
+//
+// Purpose: Generates a non-empty command list: commands, && / || chains,
+//          background commands and function definitions.
+//
+// *****************************************************************************
+//
+static struct AstNode *genList(int depth)
+{
+    struct AstNode *first = NULL;
+    struct AstNode *last = NULL;
+    struct AstNode *node;
+    struct AstNode *op;
+    int count = 1 + (int)rnd(3);
+    int ops;
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        node = genCommand(depth);
+        if(node->type == N_CMD && rnd(5) == 0)
+        {
+            node->bg = 1;
+        }
+        else if(rnd(4) == 0)
+        {
+            // An && / || chain, grouped to the left.
+            //
+            for(ops = 1 + (int)rnd(3); ops > 0; ops--)
+            {
+                op = genNode(rnd(2) ? N_AND : N_OR);
+                op->left = node;
+                op->right = genCommand(depth);
+                node = op;
+            }
+        }
+        else if(depth < GEN_DEPTH && rnd(8) == 0)
+        {
+            op = genNode(N_FUNCDEF);
+            op->name = PICK(names);
+            op->body = genCommand(depth + 1);
+            if(op->body->type == N_CMD)
+            {
+                op->body = genNode(N_GROUP);
+                op->body->body = genList(depth + 1);
+            }
+            node = op;
+        }
+
+        if(first == NULL)
+        {
+            first = node;
+        }
+        else
+        {
+            last->next = node;
+        }
+        last = node;
+    }
+
+    return first;
+}
+
+
+// *****************************************************************************
+//
+// static void blank(FILE *out, int needed)
+//
+// Purpose: Writes the space between two tokens: one or more blanks, or (if
+//          the tokens do not need separating) possibly none.
+//
+// *****************************************************************************
+//
+static void blank(FILE *out, int needed)
+{
+    switch(rnd(needed ? 3 : 4))
+    {
+        case 0:  fputc(' ', out);     break;
+        case 1:  fputs("\t ", out);   break;
+        case 2:  fputs("  \r", out);  break;
+        default: break;
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void lineEnd(FILE *out)
+//
+// Purpose: Writes a newline, sometimes after a comment.
+//
+// *****************************************************************************
+//
+static void lineEnd(FILE *out)
+{
+    if(rnd(4) == 0)
+    {
+        fputs(" # a comment; if then { && < fi", out);
+    }
+    fputc('\n', out);
+}
+
+
+static void writeList(FILE *out, struct AstNode *list, int terminated);
+static void writeCommand(FILE *out, struct AstNode *node);
+
+
+// *****************************************************************************
+//
+// static void writeIf(FILE *out, struct AstNode *node, const char *keyword)
+//
+// Purpose: Writes an if command, starting with keyword ("if" or "elif").
+//
+// *****************************************************************************
+//
+static void writeIf(FILE *out, struct AstNode *node, const char *keyword)
+{
+    fputs(keyword, out);
+    blank(out, 1);
+    writeList(out, node->cond, 1);
+    fputs("then", out);
+    blank(out, 1);
+    writeList(out, node->body, 1);
+
+    if(node->elseBody != NULL && node->elseBody->type == N_IF &&
+       node->elseBody->next == NULL && rnd(2))
+    {
+        writeIf(out, node->elseBody, "elif");
+        return;
+    }
+    if(node->elseBody != NULL)
+    {
+        fputs("else", out);
+        blank(out, 1);
+        writeList(out, node->elseBody, 1);
+    }
+    fputs("fi", out);
+}
+
+
+// *****************************************************************************
+//
+// static void writeCommand(FILE *out, struct AstNode *node)
+//
+// Purpose: Writes one command (not its list separator) as script text.
+//
+// *****************************************************************************
+//
+static void writeCommand(FILE *out, struct AstNode *node)
+{
+    int inAt;                   // Word index the < f goes before
+    int outAt;                  // Word index the > f goes before
+    int i;
+
+    switch(node->type)
+    {
+        case N_CMD:
+            inAt = (int)rnd(node->numWords + 1);
+            outAt = (int)rnd(node->numWords + 1);
+            for(i = 0; i <= node->numWords; i++)
+            {
+                if(i == inAt && node->redirIn != NULL)
+                {
+                    fputc('<', out);
+                    blank(out, 0);
+                    fprintf(out, "%s", node->redirIn);
+                    blank(out, 1);
+                }
+                if(i == outAt && node->redirOut != NULL)
+                {
+                    fputc('>', out);
+                    blank(out, 0);
+                    fprintf(out, "%s", node->redirOut);
+                    blank(out, 1);
+                }
+                if(i < node->numWords)
+                {
+                    fprintf(out, "%s", node->words[i]);
+                    blank(out, 1);
+                }
+            }
+            break;
+        case N_AND:
+        case N_OR:
+            writeCommand(out, node->left);
+            blank(out, 0);
+            fputs(node->type == N_AND ? "&&" : "||", out);
+            blank(out, 0);
+            if(rnd(3) == 0)
+            {
+                lineEnd(out);
+            }
+            writeCommand(out, node->right);
+            break;
+        case N_IF:
+            writeIf(out, node, "if");
+            blank(out, 0);
+            break;
+        case N_WHILE:
+        case N_UNTIL:
+            fputs(node->type == N_WHILE ? "while" : "until", out);
+            blank(out, 1);
+            writeList(out, node->cond, 1);
+            fputs("do", out);
+            blank(out, 1);
+            writeList(out, node->body, 1);
+            fputs("done", out);
+            blank(out, 0);
+            break;
+        case N_FOR:
+            fprintf(out, "for %s", node->name);
+            blank(out, 1);
+            if(node->hasIn)
+            {
+                fputs("in", out);
+                for(i = 0; i < node->numWords; i++)
+                {
+                    blank(out, 1);
+                    fprintf(out, "%s", node->words[i]);
+                }
+                blank(out, 0);
+                if(rnd(2))
+                {
+                    fputc(';', out);
+                }
+                else
+                {
+                    lineEnd(out);
+                }
+            }
+            else if(rnd(2))
+            {
+                fputc(';', out);
+            }
+            if(rnd(2))
+            {
+                lineEnd(out);
+            }
+            fputs("do", out);
+            blank(out, 1);
+            writeList(out, node->body, 1);
+            fputs("done", out);
+            blank(out, 0);
+            break;
+        case N_GROUP:
+            fputc('{', out);
+            blank(out, 1);
+            writeList(out, node->body, 1);
+            fputc('}', out);
+            blank(out, 0);
+            break;
+        case N_FUNCDEF:
+            fprintf(out, "%s", node->name);
+            blank(out, 0);
+            fputs("()", out);
+            blank(out, 0);
+            if(rnd(3) == 0)
+            {
+                lineEnd(out);
+            }
+            writeCommand(out, node->body);
+            break;
+    }
+}
+
+
+// *****************************************************************************
+//
+// static void writeList(FILE *out, struct AstNode *list, int terminated)
+//
+// Purpose: Writes a command list with ';', '&' or newlines between the
+//          commands. If terminated is set the last command is followed by a
+//          separator too, as a list before "then", "done" or "}" must be.
+//
+// *****************************************************************************
+//
+static void writeList(FILE *out, struct AstNode *list, int terminated)
+{
+    for(; list != NULL; list = list->next)
+    {
+        writeCommand(out, list);
+        if(list->bg)
+        {
+            fputc('&', out);
+            blank(out, 0);
+            if(rnd(3) == 0)
+            {
+                lineEnd(out);
+            }
+        }
+        else if(list->next != NULL || terminated || rnd(2))
+        {
+            if(rnd(2))
+            {
+                fputc(';', out);
+                blank(out, 0);
+            }
+            else
+            {
+                lineEnd(out);
+            }
+        }
+        if(rnd(5) == 0)
+        {
+            lineEnd(out);
+        }
+    }
+}
+
+
+// *****************************************************************************
+//
+// static int fail(uint64_t seed, long n, const char *what, const char *src,
+//                 size_t len, const char *want, const char *got)
+//
+// Purpose: Reports a failed property and returns 1.
+//
+// *****************************************************************************
+//
+static int fail(uint64_t seed, long n, const char *what, const char *src,
+                size_t len, const char *want, const char *got)
+{
+    if(n < 0)
+    {
+        fprintf(stderr, "parse_props: fixed input: %s\n", what);
+    }
+    else
+    {
+        fprintf(stderr, "parse_props: case %ld (seed %#llx): %s\n", n,
+                (unsigned long long)seed, what);
+    }
+    fprintf(stderr, "--- script:\n%.*s\n---\n", (int)len, src);
+    if(want != NULL)
+    {
+        fprintf(stderr, "want: %s\n", want);
+    }
+    if(got != NULL)
+    {
+        fprintf(stderr, "got:  %s\n", got);
+    }
+
+    return 1;
+}
+
+
+// *****************************************************************************
+//
+// static int genCase(uint64_t seed, long n)
+//
+// Purpose: Generates one script and checks every property on it. Returns 0
+//          if they all hold.
+//
+// *****************************************************************************
+//
+static int genCase(uint64_t seed, long n)
+{
+    struct Arena arena;
+    struct AstNode *gen;
+    struct AstNode *tree;
+    char errMsg[128];
+    char *src = NULL;
+    size_t len = 0;
+    char *want;
+    char *got = NULL;
+    const char *why;
+    FILE *out;
+    size_t i;
+    int bad = 0;
+    int result;
+
+    arenaReset(&genArena);
+    gen = genList(0);
+    want = treeString(gen);
+
+    out = open_memstream(&src, &len);
+    if(out == NULL)
+    {
+        perror("open_memstream()");
+        exit(1);
+    }
+    writeList(out, gen, 0);
+    fclose(out);
+
+    arenaInit(&arena);
+    result = parseScript(src, len, &arena, &tree, errMsg, sizeof(errMsg));
+    if(result != PARSE_OK)
+    {
+        bad = fail(seed, n, "script does not parse", src, len, want, errMsg);
+    }
+    else
+    {
+        got = treeString(tree);
+        if(strcmp(want, got) != 0)
+        {
+            bad = fail(seed, n, "script parses to a different tree", src, len, want, got);
+        }
+    }
+
+    // Statements are read a line at a time; none may look wrong before its
+    // last line is in.
+    //
+    for(i = 0; !bad && i + 1 < len; i++)
+    {
+        if(src[i] != '\n')
+        {
+            continue;
+        }
+        arenaReset(&arena);
+        if(parseScript(src, i + 1, &arena, &tree, errMsg, sizeof(errMsg)) == PARSE_ERROR)
+        {
+            bad = fail(seed, n, "a line prefix is a syntax error", src, i + 1, NULL, errMsg);
+        }
+    }
+
+    // The general checks, on the script and on some truncations of it.
+    //
+    why = checkParse(src, len);
+    if(!bad && why != NULL)
+    {
+        bad = fail(seed, n, why, src, len, NULL, NULL);
+    }
+    for(i = 0; !bad && i < 4 && len > 0; i++)
+    {
+        size_t cut = rnd(len);
+
+        why = checkParse(src, cut);
+        if(why != NULL)
+        {
+            bad = fail(seed, n, why, src, cut, NULL, NULL);
+        }
+    }
+
+    arenaFree(&arena);
+    free(want);
+    free(got);
+    free(src);
+
+    return bad;
+}
+
+
+// struct FixedCase: A hand-written input and the parse result it must get
+//
+// (len is only given for inputs with a NUL byte in them.)
+//
+struct FixedCase {
+    const char *src;
+    int result;
+    size_t len;
+};
+
+static const struct FixedCase fixedCases[] = {
+    { "", PARSE_OK },
+    { "\n\n  # just a comment\n", PARSE_OK },
+    { "<", PARSE_ERROR },
+    { "echo hi <", PARSE_ERROR },
+    { "echo hi >", PARSE_ERROR },
+    { "echo hi < ;", PARSE_ERROR },
+    { "echo hi > &", PARSE_ERROR },
+    { "< in", PARSE_OK },
+    { "> out &", PARSE_OK },
+    { "&", PARSE_ERROR },
+    { "echo & &", PARSE_ERROR },
+    { "& echo", PARSE_ERROR },
+    { ";", PARSE_ERROR },
+    { "&&", PARSE_ERROR },
+    { "echo &&", PARSE_INCOMPLETE },
+    { "echo ||\n", PARSE_INCOMPLETE },
+    { "cd", PARSE_OK },
+    { "cd ; cd", PARSE_OK },
+    { "if true; then echo; fi &", PARSE_ERROR },
+    { "a && b &", PARSE_ERROR },
+    { "if true; then", PARSE_INCOMPLETE },
+    { "if true; then fi", PARSE_ERROR },
+    { "while true; do echo; done done", PARSE_ERROR },
+    { "for 1x in a; do b; done", PARSE_ERROR },
+    { "for x in a do; done", PARSE_ERROR },
+    { "f() echo", PARSE_ERROR },
+    { "1f() { a; }", PARSE_ERROR },
+    { "f(", PARSE_INCOMPLETE },
+    { "f()", PARSE_INCOMPLETE },
+    { "f() { a; }", PARSE_OK },
+    { ")", PARSE_ERROR },
+    { "}", PARSE_ERROR },
+    { "echo x\0y", PARSE_OK, 8 },
+};
+
+
+// *****************************************************************************
+//
+// static int fixedCase(const char *src, size_t len, int want)
+//
+// Purpose: Checks one hand-written input. Returns 0 if it got the expected
+//          result and passed checkParse().
+//
+// *****************************************************************************
+//
+static int fixedCase(const char *src, size_t len, int want)
+{
+    struct Arena arena;
+    struct AstNode *tree;
+    char errMsg[128];
+    char result[64];
+    const char *why;
+    int got;
+
+    arenaInit(&arena);
+    got = parseScript(src, len, &arena, &tree, errMsg, sizeof(errMsg));
+    arenaFree(&arena);
+
+    why = checkParse(src, len);
+    if(got != want || why != NULL)
+    {
+        snprintf(result, sizeof(result), "result %d, wanted %d", got, want);
+        return fail(0, -1, why != NULL ? why : result, src, len, NULL, errMsg);
+    }
+
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// static char *repeat(const char *str, int times, const char *tail)
+//
+// Purpose: Builds a long input: str repeated, then tail.
+//
+// *****************************************************************************
+//
+static char *repeat(const char *str, int times, const char *tail)
+{
+    char *buf;
+    size_t len = strlen(str);
+    int i;
+
+    buf = (char *) malloc(len * times + strlen(tail) + 1);
+    if(buf == NULL)
+    {
+        perror("malloc()");
+        exit(1);
+    }
+    for(i = 0; i < times; i++)
+    {
+        memcpy(buf + i * len, str, len);
+    }
+    strcpy(buf + len * times, tail);
+
+    return buf;
+}
+
+
+int main(int argc, char *argv[])
+{
+    long cases = 2000;          // Random scripts to try (-n)
+    uint64_t seed = 1;          // Random seed (-s)
+    int failed = 0;
+    char *big;
+    size_t i;
+    long n;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                cases = atol(optarg);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n cases] [-s seed]\n", argv[0]);
+                exit(2);
+        }
+    }
+
+    for(i = 0; i < sizeof(fixedCases) / sizeof(fixedCases[0]); i++)
+    {
+        failed += fixedCase(fixedCases[i].src,
+                            fixedCases[i].len > 0 ? fixedCases[i].len : strlen(fixedCases[i].src),
+                            fixedCases[i].result);
+    }
+
+    // Inputs that are only wrong for being too big: too many words, too
+    // long an && chain, nesting too deep. They must be refused, not crash.
+    //
+    big = repeat("w ", MAX_ARGS, "");
+    failed += fixedCase(big, strlen(big), PARSE_ERROR);
+    free(big);
+    big = repeat("w && ", MAX_ARGS, "w");
+    failed += fixedCase(big, strlen(big), PARSE_ERROR);
+    free(big);
+    big = repeat("{ ", MAX_NEST + 1, "w; }");
+    failed += fixedCase(big, strlen(big), PARSE_ERROR);
+    free(big);
+    big = repeat("if a; then b; elif ", MAX_NEST + 1, "c; then d; fi");
+    failed += fixedCase(big, strlen(big), PARSE_ERROR);
+    free(big);
+    big = repeat("{ ", MAX_NEST - 1, "w;");
+    failed += fixedCase(big, strlen(big), PARSE_INCOMPLETE);
+    free(big);
+
+    arenaInit(&genArena);
+    for(n = 0; n < cases && failed == 0; n++)
+    {
+        rngState = (seed + (uint64_t)n) * 0x9e3779b97f4a7c15ull | 1;
+        failed += genCase(seed, n);
+    }
+    arenaFree(&genArena);
+
+    if(failed > 0)
+    {
+        fprintf(stderr, "parse_props: FAILED\n");
+        return 1;
+    }
+    printf("parse_props: %ld generated scripts and %zu fixed inputs passed\n",
+           cases, sizeof(fixedCases) / sizeof(fixedCases[0]) + 5);
+
+    return 0;
+}
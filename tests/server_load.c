@@ -0,0 +1,152 @@
+//
+// *****************************************************************************
+//
+// Author:    smallsh contributors
+// Date:      October 19, 2026
+// Project:   smallsh
+// Filename:  tests/server_load.c
+//
+//
+// Overview:
+//    Misbehaving clients for server mode ('smallsh -l socket'), used by
+//    tests/server_test.sh. smallsh-client only ever sends one complete
+//    request; these do what it never would:
+//
+//       server_load idle socket count seconds
+//          Opens count connections, sends nothing on them, and holds them
+//          for seconds before closing them.
+//
+//       server_load pending socket count
+//          Starts count requests on one connection (one FRAME_ARG each)
+//          without ever sending FRAME_RUN, then prints "hung up" if the
+//          shell closed the connection and "open" if it did not.
+//
+// *****************************************************************************
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../smallsh_proto.h"
+
+
+// *****************************************************************************
+//
+// static int connectTo(const char *path)
+//
+// Purpose: Connects to the shell's socket, exiting if that fails.
+//
+// *****************************************************************************
+//
+static int connectTo(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    return fd;
+}
+
+
+// *****************************************************************************
+//
+// static int pending(const char *path, int count)
+//
+// Purpose: Opens count unstarted requests, then reports whether the shell
+//          hung up. A write failing because it already has counts as a
+//          hang-up too.
+//
+// *****************************************************************************
+//
+static int pending(const char *path, int count)
+{
+    struct FrameHeader hdr;
+    struct pollfd pfd;
+    char frame[sizeof(hdr) + 4];
+    char buf[4096];
+    ssize_t n;
+    int fd = connectTo(path);
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        hdr.type = FRAME_ARG;
+        hdr.id = (uint32_t)i + 1;
+        hdr.len = 4;
+        memcpy(frame, &hdr, sizeof(hdr));
+        memcpy(frame + sizeof(hdr), "true", 4);
+        if(send(fd, frame, sizeof(frame), MSG_NOSIGNAL) != (ssize_t)sizeof(frame))
+        {
+            printf("hung up\n");
+            return 0;
+        }
+    }
+
+    // Anything the shell sends back is an error frame at most; what
+    // matters is whether the connection reaches end of file.
+    //
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while(poll(&pfd, 1, 2000) == 1)
+    {
+        n = read(fd, buf, sizeof(buf));
+        if(n <= 0)
+        {
+            printf("hung up\n");
+            return 0;
+        }
+    }
+
+    printf("open\n");
+    return 0;
+}
+
+
+// *****************************************************************************
+//
+// int main(int argc, char *argv[])
+//
+// Purpose: Runs the mode named on the command line.
+//
+// *****************************************************************************
+//
+int main(int argc, char *argv[])
+{
+    int count;
+    int i;
+
+    if(argc == 5 && strcmp(argv[1], "idle") == 0)
+    {
+        count = atoi(argv[3]);
+        for(i = 0; i < count; i++)
+        {
+            connectTo(argv[2]);
+        }
+        sleep((unsigned int)atoi(argv[4]));
+        return 0;
+    }
+    if(argc == 4 && strcmp(argv[1], "pending") == 0)
+    {
+        return pending(argv[2], atoi(argv[3]));
+    }
+
+    fprintf(stderr, "usage: server_load idle socket count seconds\n"
+                    "       server_load pending socket count\n");
+    return 2;
+}
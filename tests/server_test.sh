@@ -0,0 +1,161 @@
+#!/bin/sh
+#
+# *****************************************************************************
+#
+# Project:   smallsh
+# Filename:  tests/server_test.sh
+#
+#
+# Overview:
+#    Load tests for server mode ('smallsh -l socket'), run once with each
+#    I/O backend (io_uring, then SMALLSH_IO=epoll). Each case checks that
+#    the clients get their answers and that the shell did not spin while
+#    serving them: it may use at most MAXCPU hundredths of a second of CPU
+#    time per case.
+#
+#       descriptors   the shell is limited to 16 open files and 20 idle
+#                     connections are held open for 2 seconds: accepting
+#                     waits for descriptors to free up instead of retrying
+#                     at full speed. Then 20 clients at once: requests that
+#                     get accepted may fail for want of pipes, but every
+#                     client must get an answer, and the shell must serve
+#                     normally once they are gone
+#       streams       40 clients each read 'seq 1 300000' (about 2 MB) at
+#                     once: more reads are due than there are pool
+#                     buffers, and each must wait its turn for one instead
+#                     of being retried at full speed
+#       idle          70 connections that send nothing do not keep
+#                     another client from being served
+#       pending       a client that opens more unstarted requests than the
+#                     shell allows is hung up on; others are still served
+#
+#    Usage: tests/server_test.sh [smallsh] [smallsh-client] [server_load]
+#
+# *****************************************************************************
+#
+
+SMALLSH=${1:-./smallsh}
+CLIENT=${2:-./smallsh-client}
+LOAD=${3:-tests/server_load}
+MAXCPU=${MAXCPU:-100}
+
+DIR=$(mktemp -d) || exit 1
+SOCK=$DIR/sock
+SRV=""
+FAILED=0
+
+cleanup()
+{
+    [ -n "$SRV" ] && kill "$SRV" 2> /dev/null
+    rm -rf "$DIR"
+}
+trap cleanup EXIT
+
+echo ok > "$DIR/ok"
+seq 1 300000 > "$DIR/seq"
+
+# Prints the user + system CPU time process $1 has used, in clock ticks
+# (hundredths of a second on Linux).
+#
+cpuTime()
+{
+    awk '{ print $14 + $15 }' "/proc/$1/stat"
+}
+
+# Starts the shell as a server with backend $1, and a descriptor limit of
+# $2 if given.
+#
+startServer()
+{
+    rm -f "$SOCK"
+    (
+        [ -n "$2" ] && ulimit -n "$2"
+        SMALLSH_IO=$1 exec "$SMALLSH" -l "$SOCK"
+    ) 2> "$DIR/server.err" &
+    SRV=$!
+    n=0
+    while [ ! -S "$SOCK" ] && [ $n -lt 100 ]; do
+        sleep 0.05
+        n=$((n + 1))
+    done
+    CPU0=$(cpuTime $SRV)
+}
+
+# Stops the server and reports case $2 for backend $1 as passed if $3 is
+# "ok" and the server stayed under MAXCPU.
+#
+stopServer()
+{
+    cpu=$(( $(cpuTime $SRV) - CPU0 ))
+    kill $SRV
+    wait $SRV 2> /dev/null
+    SRV=""
+    res=$3
+    [ "$res" = ok ] && [ $cpu -gt "$MAXCPU" ] && res="busy"
+    if [ "$res" = ok ]; then
+        printf '%-9s %-12s ok   (cpu %d)\n' "$1" "$2" $cpu
+    else
+        printf '%-9s %-12s FAIL (%s, cpu %d)\n' "$1" "$2" "$res" $cpu
+        FAILED=1
+    fi
+}
+
+# Runs $1 copies of 'smallsh-client socket args...' at once and prints how
+# many printed what is in file $2. Clients that get no answer within 30
+# seconds are counted in $DIR/timeouts.
+#
+clients()
+{
+    count=$1
+    expect=$2
+    shift 2
+    : > "$DIR/timeouts"
+    i=0
+    while [ $i -lt "$count" ]; do
+        {
+            timeout 30 "$CLIENT" "$SOCK" "$@" > "$DIR/out.$i" 2>&1
+            [ $? = 124 ] && echo $i >> "$DIR/timeouts"
+        } &
+        i=$((i + 1))
+    done
+    wait
+    for out in "$DIR"/out.*; do
+        cmp -s "$out" "$expect" && echo
+    done | wc -l
+    rm -f "$DIR"/out.*
+}
+
+for backend in io_uring epoll; do
+    startServer $backend 16
+    "$LOAD" idle "$SOCK" 20 2
+    (clients 20 "$DIR/ok" sh -c 'sleep 0.5; echo ok') > /dev/null
+    res=ok
+    if [ -s "$DIR/timeouts" ]; then
+        res="$(wc -l < "$DIR/timeouts") of 20 not answered"
+    elif [ "$(clients 1 "$DIR/ok" echo ok)" != 1 ]; then
+        res="not served afterwards"
+    fi
+    stopServer $backend descriptors "$res"
+
+    startServer $backend
+    got=$(clients 40 "$DIR/seq" seq 1 300000)
+    [ "$got" = 40 ] && res=ok || res="$got of 40 correct"
+    stopServer $backend streams "$res"
+
+    startServer $backend
+    "$LOAD" idle "$SOCK" 70 3 &
+    sleep 0.5
+    [ "$(clients 1 "$DIR/ok" echo ok)" = 1 ] && res=ok || res="not served"
+    wait $!
+    stopServer $backend idle "$res"
+
+    startServer $backend
+    res=$("$LOAD" pending "$SOCK" 100)
+    [ "$res" = "hung up" ] && res=ok
+    if [ "$res" = ok ] && [ "$(clients 1 "$DIR/ok" echo ok)" != 1 ]; then
+        res="not served afterwards"
+    fi
+    stopServer $backend pending "$res"
+done
+
+exit $FAILED